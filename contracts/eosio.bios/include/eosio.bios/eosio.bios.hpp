@@ -1,11 +1,13 @@
 #pragma once
 
 #include <eosio/action.hpp>
+#include <eosio/binary_extension.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/fixed_bytes.hpp>
 #include <eosio/privileged.hpp>
 #include <eosio/producer_schedule.hpp>
+#include <eosio/time.hpp>
 
 /**
  * EOSIO Contracts
@@ -85,6 +87,33 @@ namespace eosiobios {
                                      (schedule_version)(new_producers))
    };
 
+   struct account_limits {
+      name     account;
+      int64_t  ram_bytes;
+      int64_t  net_weight;
+      int64_t  cpu_weight;
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( account_limits, (account)(ram_bytes)(net_weight)(cpu_weight) )
+   };
+
+   struct account_privilege {
+      name     account;
+      bool     is_priv;
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( account_privilege, (account)(is_priv) )
+   };
+
+   struct account_abi_hash {
+      name        account;
+      checksum256 hash;
+      uint32_t    size;
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( account_abi_hash, (account)(hash)(size) )
+   };
+
    class [[eosio::contract("eosio.bios")]] bios : public eosio::contract {
       public:
          using contract::contract;
@@ -186,8 +215,9 @@ namespace eosiobios {
 
          /**
           * Set abi action sets the abi for contract identified by `account` name. Creates an entry in the abi_hash_table
-          * index, with `account` name as key, if it is not already present and sets its value with the abi hash.
-          * Otherwise it is updating the current abi hash value for the existing `account` key.
+          * index, with `account` name as key, if it is not already present and sets its value with the abi hash,
+          * the abi size and the time of the current block. Otherwise it is updating these values for the existing
+          * `account` key, unless the abi hash is unchanged.
           *
           * @param account - the name of the account to set the abi for
           * @param abi     - the abi hash represented as a vector of characters
@@ -225,6 +255,20 @@ namespace eosiobios {
          [[eosio::action]]
          void setalimits( name account, int64_t ram_bytes, int64_t net_weight, int64_t cpu_weight );
 
+         /**
+          * Bootstrap action, applies the settings of many accounts at once when bringing up a new chain.
+          * It has the same effect as calling `setalimits` for each entry of `limits`, `setpriv` for each entry
+          * of `privileges`, and recording each entry of `abi_hashes` in the abi_hash_table as `setabi` does.
+          * The RAM of new abi_hash_table entries is billed to this contract.
+          *
+          * @param limits - resource limits of accounts, as in `setalimits`
+          * @param privileges - privileged status of accounts, as in `setpriv`
+          * @param abi_hashes - hashes and sizes of the abis already set on accounts
+          */
+         [[eosio::action]]
+         void bootstrap( const std::vector<account_limits>& limits, const std::vector<account_privilege>& privileges,
+                         const std::vector<account_abi_hash>& abi_hashes );
+
          /**
           * Set producers action, sets a new list of active producers, by proposing a schedule change, once the block that
           * contains the proposal becomes irreversible, the schedule is promoted to "pending"
@@ -272,9 +316,12 @@ namespace eosiobios {
          struct [[eosio::table]] abi_hash {
             name              owner;
             checksum256       hash;
+            // size of the abi and time of the block that last changed it, missing in entries recorded before they were stored
+            eosio::binary_extension<uint32_t>                size;
+            eosio::binary_extension<eosio::block_timestamp>  last_update;
             uint64_t primary_key()const { return owner.value; }
 
-            EOSLIB_SERIALIZE( abi_hash, (owner)(hash) )
+            EOSLIB_SERIALIZE( abi_hash, (owner)(hash)(size)(last_update) )
          };
 
          typedef eosio::multi_index< "abihash"_n, abi_hash > abi_hash_table;
@@ -289,10 +336,14 @@ namespace eosiobios {
          using setabi_action = action_wrapper<"setabi"_n, &bios::setabi>;
          using setpriv_action = action_wrapper<"setpriv"_n, &bios::setpriv>;
          using setalimits_action = action_wrapper<"setalimits"_n, &bios::setalimits>;
+         using bootstrap_action = action_wrapper<"bootstrap"_n, &bios::bootstrap>;
          using setprods_action = action_wrapper<"setprods"_n, &bios::setprods>;
          using setparams_action = action_wrapper<"setparams"_n, &bios::setparams>;
          using reqauth_action = action_wrapper<"reqauth"_n, &bios::reqauth>;
          using activate_action = action_wrapper<"activate"_n, &bios::activate>;
          using reqactivated_action = action_wrapper<"reqactivated"_n, &bios::reqactivated>;
+
+      private:
+         void store_abi_hash( abi_hash_table& table, name account, const checksum256& hash, uint32_t size, name payer );
    };
 }
@@ -4,15 +4,24 @@ namespace eosiobios {
 
 void bios::setabi( name account, const std::vector<char>& abi ) {
    abi_hash_table table(get_self(), get_self().value);
+   store_abi_hash( table, account, eosio::sha256(const_cast<char*>(abi.data()), abi.size()), abi.size(), account );
+}
+
+void bios::store_abi_hash( abi_hash_table& table, name account, const checksum256& hash, uint32_t size, name payer ) {
    auto itr = table.find( account.value );
    if( itr == table.end() ) {
-      table.emplace( account, [&]( auto& row ) {
-         row.owner = account;
-         row.hash  = eosio::sha256(const_cast<char*>(abi.data()), abi.size());
+      table.emplace( payer, [&]( auto& row ) {
+         row.owner       = account;
+         row.hash        = hash;
+         row.size        = size;
+         row.last_update = eosio::current_block_time();
       });
-   } else {
+   } else if( itr->hash != hash || !itr->size ) {
+      // setting an identical abi again does not rewrite the entry
       table.modify( itr, eosio::same_payer, [&]( auto& row ) {
-         row.hash = eosio::sha256(const_cast<char*>(abi.data()), abi.size());
+         row.hash        = hash;
+         row.size        = size;
+         row.last_update = eosio::current_block_time();
       });
    }
 }
@@ -31,6 +40,23 @@ void bios::setalimits( name account, int64_t ram_bytes, int64_t net_weight, int6
    set_resource_limits( account, ram_bytes, net_weight, cpu_weight );
 }
 
+void bios::bootstrap( const std::vector<account_limits>& limits, const std::vector<account_privilege>& privileges,
+                      const std::vector<account_abi_hash>& abi_hashes ) {
+   require_auth( get_self() );
+
+   for( const auto& l : limits ) {
+      set_resource_limits( l.account, l.ram_bytes, l.net_weight, l.cpu_weight );
+   }
+   for( const auto& p : privileges ) {
+      set_privileged( p.account, p.is_priv );
+   }
+
+   abi_hash_table table(get_self(), get_self().value);
+   for( const auto& a : abi_hashes ) {
+      store_abi_hash( table, a.account, a.hash, a.size, get_self() );
+   }
+}
+
 void bios::setprods( const std::vector<eosio::producer_authority>& schedule ) {
    require_auth( get_self() );
    set_proposed_producers( schedule );
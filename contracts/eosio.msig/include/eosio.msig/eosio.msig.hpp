@@ -5,6 +5,8 @@
 #include <eosio/ignore.hpp>
 #include <eosio/transaction.hpp>
 
+#include <optional>
+
 namespace eosio {
     
    /**
@@ -17,6 +19,15 @@ namespace eosio {
       public:
          using contract::contract;
 
+         /**
+          * A proposal to approve with `approvemany`, and optionally the checksum of its transaction.
+          */
+         struct proposal_approval {
+            name                               proposer;
+            name                               proposal_name;
+            std::optional<eosio::checksum256>  proposal_hash;
+         };
+
          /**
           * Propose action, creates a proposal containing one transaction.
           * Allows an account `proposer` to make a proposal `proposal_name` which has `requested`
@@ -46,11 +57,21 @@ namespace eosio {
           * @param proposer - The account proposing a transaction
           * @param proposal_name - The name of the proposal (should be unique for proposer)
           * @param level - Permission level approving the transaction
-          * @param proposal_hash - Transaction's checksum
+          * @param proposal_hash - Transaction's checksum, compared with the checksum stored by `propose`
           */
          [[eosio::action]]
          void approve( name proposer, name proposal_name, permission_level level,
                        const eosio::binary_extension<eosio::checksum256>& proposal_hash );
+         /**
+          * Approvemany action approves several existing proposals with the same `level` permission.
+          * Each proposal is approved as if by the `approve` action, and the whole action fails if any
+          * of the approvals fails.
+          *
+          * @param level - Permission level approving the transactions
+          * @param requests - The proposals to approve, with their optional transaction checksums
+          */
+         [[eosio::action]]
+         void approvemany( permission_level level, std::vector<proposal_approval> requests );
          /**
           * Unapprove action revokes an existing proposal. This action is the reverse of the `approve` action: if all validations pass
           * the `level` permission is erased from internal `provided_approvals` and added to the internal
@@ -102,18 +123,34 @@ namespace eosio {
           */
          [[eosio::action]]
          void invalidate( name account );
+         /**
+          * Purge action deletes expired proposals.
+          *
+          * Deletes up to `max` proposals whose transaction has expired, oldest expiration first, together
+          * with their approvals. The RAM of the deleted rows is returned to the proposers. Anyone can
+          * purge expired proposals. Proposals created before expirations were recorded are not purged
+          * and can still be removed with `cancel`.
+          *
+          * @param max - Maximum number of proposals to delete
+          */
+         [[eosio::action]]
+         void purge( uint16_t max );
 
          using propose_action = eosio::action_wrapper<"propose"_n, &multisig::propose>;
          using approve_action = eosio::action_wrapper<"approve"_n, &multisig::approve>;
+         using approvemany_action = eosio::action_wrapper<"approvemany"_n, &multisig::approvemany>;
          using unapprove_action = eosio::action_wrapper<"unapprove"_n, &multisig::unapprove>;
          using cancel_action = eosio::action_wrapper<"cancel"_n, &multisig::cancel>;
          using exec_action = eosio::action_wrapper<"exec"_n, &multisig::exec>;
          using invalidate_action = eosio::action_wrapper<"invalidate"_n, &multisig::invalidate>;
+         using purge_action = eosio::action_wrapper<"purge"_n, &multisig::purge>;
 
       private:
          struct [[eosio::table]] proposal {
-            name                            proposal_name;
-            std::vector<char>               packed_transaction;
+            name                                           proposal_name;
+            std::vector<char>                              packed_transaction;
+            //sha256 of packed_transaction, missing in proposals created before it was stored
+            eosio::binary_extension<eosio::checksum256>    trx_hash;
 
             uint64_t primary_key()const { return proposal_name.value; }
          };
@@ -135,7 +172,9 @@ namespace eosio {
          };
 
          struct [[eosio::table]] approvals_info {
-            uint8_t                 version = 1;
+            //version 1 keeps approvals in the order they were added, version 2 keeps both lists
+            //sorted by permission level. Version 1 rows are sorted the next time they are modified.
+            uint8_t                 version = 2;
             name                    proposal_name;
             //requested approval doesn't need to cointain time, but we want requested approval
             //to be of exact the same size ad provided approval, in this case approve/unapprove
@@ -147,6 +186,14 @@ namespace eosio {
          };
          typedef eosio::multi_index< "approvals2"_n, approvals_info > approvals;
 
+         void add_approval( proposals& proptable, approvals& apptable, old_approvals& old_apptable, name proposal_name,
+                            const permission_level& level, const checksum256* proposal_hash );
+
+         static bool approval_less( const approval& a, const approval& b ) { return a.level < b.level; }
+         static void migrate_approvals( approvals_info& info );
+         static std::vector<approval>::iterator find_approval( std::vector<approval>& approvals, const permission_level& level );
+         static void insert_approval( std::vector<approval>& approvals, const approval& a );
+
          struct [[eosio::table]] invalidation {
             name         account;
             time_point   last_invalidation_time;
@@ -155,6 +202,27 @@ namespace eosio {
          };
 
          typedef eosio::multi_index< "invals"_n, invalidation > invalidations;
+
+         //expirations of all proposals, in the contract scope, so that expired proposals can be found without
+         //scanning every proposer scope or unpacking transaction headers
+         struct [[eosio::table]] proposal_expiration {
+            uint64_t         id;
+            name             proposer;
+            name             proposal_name;
+            time_point_sec   expiration;
+
+            uint64_t  primary_key()const { return id; }
+            uint64_t  by_expiration()const { return expiration.sec_since_epoch(); }
+            uint128_t by_proposal()const { return (uint128_t(proposer.value) << 64) | proposal_name.value; }
+         };
+
+         typedef eosio::multi_index< "expirations"_n, proposal_expiration,
+                                     indexed_by<"byexpiration"_n, const_mem_fun<proposal_expiration, uint64_t, &proposal_expiration::by_expiration>>,
+                                     indexed_by<"byproposal"_n, const_mem_fun<proposal_expiration, uint128_t, &proposal_expiration::by_proposal>>
+                                   > proposal_expirations;
+
+         void erase_approvals( name proposer, name proposal_name );
+         void erase_expiration( name proposer, name proposal_name );
    };
    /** @}*/ // end of @defgroup eosiomsig eosio.msig
 } /// namespace eosio
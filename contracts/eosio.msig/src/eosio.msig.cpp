@@ -4,6 +4,10 @@
 
 #include <eosio.msig/eosio.msig.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <optional>
+
 namespace eosio {
 
 void multisig::propose( ignore<name> proposer,
@@ -16,7 +20,10 @@ void multisig::propose( ignore<name> proposer,
    std::vector<permission_level> _requested;
    transaction_header _trx_header;
 
-   _ds >> _proposer >> _proposal_name >> _requested;
+   _ds >> _proposer >> _proposal_name;
+   const char* requested_pos = _ds.pos();
+   _ds >> _requested;
+   const size_t requested_size = _ds.pos() - requested_pos;
 
    const char* trx_pos = _ds.pos();
    size_t size    = _ds.remaining();
@@ -29,21 +36,31 @@ void multisig::propose( ignore<name> proposer,
    proposals proptable( get_self(), _proposer.value );
    check( proptable.find( _proposal_name.value ) == proptable.end(), "proposal with the same name exists" );
 
-   auto packed_requested = pack(_requested);
+   //the requested permissions are passed as they were packed in the action data
    auto res =  check_transaction_authorization(
                   trx_pos, size,
                   (const char*)0, 0,
-                  packed_requested.data(), packed_requested.size()
+                  requested_pos, requested_size
                );
 
    check( res > 0, "transaction authorization failed" );
 
-   std::vector<char> pkd_trans;
-   pkd_trans.resize(size);
-   memcpy((char*)pkd_trans.data(), trx_pos, size);
-   proptable.emplace( _proposer, [&]( auto& prop ) {
-      prop.proposal_name       = _proposal_name;
-      prop.packed_transaction  = pkd_trans;
+   //the proposal row is serialized straight from the action data, without building a proposal object
+   //holding a copy of the transaction; the layout must match the `proposal` struct
+   std::vector<char> row( sizeof(name) + pack_size( unsigned_int(size) ) + size + sizeof(checksum256) );
+   datastream<char*> row_ds( row.data(), row.size() );
+   row_ds << _proposal_name << unsigned_int(size);
+   row_ds.write( trx_pos, size );
+   row_ds << sha256( trx_pos, size );
+   internal_use_do_not_use::db_store_i64( _proposer.value, "proposal"_n.value, _proposer.value, _proposal_name.value,
+                                          row.data(), row.size() );
+
+   proposal_expirations exptable( get_self(), get_self().value );
+   exptable.emplace( _proposer, [&]( auto& e ) {
+      e.id            = exptable.available_primary_key();
+      e.proposer      = _proposer;
+      e.proposal_name = _proposal_name;
+      e.expiration    = _trx_header.expiration;
    });
 
    approvals apptable( get_self(), _proposer.value );
@@ -53,6 +70,7 @@ void multisig::propose( ignore<name> proposer,
       for ( auto& level : _requested ) {
          a.requested_approvals.push_back( approval{ level, time_point{ microseconds{0} } } );
       }
+      std::sort( a.requested_approvals.begin(), a.requested_approvals.end(), approval_less );
    });
 }
 
@@ -61,24 +79,55 @@ void multisig::approve( name proposer, name proposal_name, permission_level leve
 {
    require_auth( level );
 
+   proposals     proptable( get_self(), proposer.value );
+   approvals     apptable( get_self(), proposer.value );
+   old_approvals old_apptable( get_self(), proposer.value );
+   add_approval( proptable, apptable, old_apptable, proposal_name, level, proposal_hash ? &*proposal_hash : nullptr );
+}
+
+void multisig::approvemany( permission_level level, std::vector<proposal_approval> requests ) {
+   require_auth( level );
+   check( !requests.empty(), "no proposals provided" );
+
+   //the proposals of each proposer are approved together, using the same tables
+   std::stable_sort( requests.begin(), requests.end(), []( const proposal_approval& a, const proposal_approval& b ) {
+      return a.proposer < b.proposer;
+   });
+   for ( auto it = requests.begin(); it != requests.end(); ) {
+      const name proposer = it->proposer;
+      proposals     proptable( get_self(), proposer.value );
+      approvals     apptable( get_self(), proposer.value );
+      old_approvals old_apptable( get_self(), proposer.value );
+      for ( ; it != requests.end() && it->proposer == proposer; ++it ) {
+         add_approval( proptable, apptable, old_apptable, it->proposal_name, level, it->proposal_hash ? &*it->proposal_hash : nullptr );
+      }
+   }
+}
+
+void multisig::add_approval( proposals& proptable, approvals& apptable, old_approvals& old_apptable, name proposal_name,
+                             const permission_level& level, const checksum256* proposal_hash )
+{
+   const name proposer( apptable.get_scope() );
+
    if( proposal_hash ) {
-      proposals proptable( get_self(), proposer.value );
       auto& prop = proptable.get( proposal_name.value, "proposal not found" );
-      assert_sha256( prop.packed_transaction.data(), prop.packed_transaction.size(), *proposal_hash );
+      if ( prop.trx_hash ) {
+         check( *prop.trx_hash == *proposal_hash, "hash mismatch" );
+      } else {
+         assert_sha256( prop.packed_transaction.data(), prop.packed_transaction.size(), *proposal_hash );
+      }
    }
 
-   approvals apptable( get_self(), proposer.value );
    auto apps_it = apptable.find( proposal_name.value );
    if ( apps_it != apptable.end() ) {
-      auto itr = std::find_if( apps_it->requested_approvals.begin(), apps_it->requested_approvals.end(), [&](const approval& a) { return a.level == level; } );
-      check( itr != apps_it->requested_approvals.end(), "approval is not on the list of requested approvals" );
-
       apptable.modify( apps_it, proposer, [&]( auto& a ) {
-            a.provided_approvals.push_back( approval{ level, current_time_point() } );
+            migrate_approvals( a );
+            auto itr = find_approval( a.requested_approvals, level );
+            check( itr != a.requested_approvals.end(), "approval is not on the list of requested approvals" );
             a.requested_approvals.erase( itr );
+            insert_approval( a.provided_approvals, approval{ level, current_time_point() } );
          });
    } else {
-      old_approvals old_apptable( get_self(), proposer.value );
       auto& apps = old_apptable.get( proposal_name.value, "proposal not found" );
 
       auto itr = std::find( apps.requested_approvals.begin(), apps.requested_approvals.end(), level );
@@ -97,11 +146,12 @@ void multisig::unapprove( name proposer, name proposal_name, permission_level le
    approvals apptable( get_self(), proposer.value );
    auto apps_it = apptable.find( proposal_name.value );
    if ( apps_it != apptable.end() ) {
-      auto itr = std::find_if( apps_it->provided_approvals.begin(), apps_it->provided_approvals.end(), [&](const approval& a) { return a.level == level; } );
-      check( itr != apps_it->provided_approvals.end(), "no approval previously granted" );
       apptable.modify( apps_it, proposer, [&]( auto& a ) {
-            a.requested_approvals.push_back( approval{ level, current_time_point() } );
+            migrate_approvals( a );
+            auto itr = find_approval( a.provided_approvals, level );
+            check( itr != a.provided_approvals.end(), "no approval previously granted" );
             a.provided_approvals.erase( itr );
+            insert_approval( a.requested_approvals, approval{ level, current_time_point() } );
          });
    } else {
       old_approvals old_apptable( get_self(), proposer.value );
@@ -118,25 +168,30 @@ void multisig::unapprove( name proposer, name proposal_name, permission_level le
 void multisig::cancel( name proposer, name proposal_name, name canceler ) {
    require_auth( canceler );
 
-   proposals proptable( get_self(), proposer.value );
-   auto& prop = proptable.get( proposal_name.value, "proposal not found" );
+   //the proposal row is found and removed without reading it; its transaction is only unpacked for
+   //proposals created before expirations were recorded
+   const int32_t prop_itr = internal_use_do_not_use::db_find_i64( get_self().value, proposer.value, "proposal"_n.value, proposal_name.value );
+   check( prop_itr >= 0, "proposal not found" );
 
+   proposal_expirations exptable( get_self(), get_self().value );
+   auto exp_idx = exptable.get_index<"byproposal"_n>();
+   auto exp_it  = exp_idx.find( (uint128_t(proposer.value) << 64) | proposal_name.value );
    if( canceler != proposer ) {
-      check( unpack<transaction_header>( prop.packed_transaction ).expiration < eosio::time_point_sec(current_time_point()), "cannot cancel until expiration" );
+      time_point_sec expiration;
+      if ( exp_it != exp_idx.end() ) {
+         expiration = exp_it->expiration;
+      } else {
+         proposals proptable( get_self(), proposer.value );
+         expiration = unpack<transaction_header>( proptable.get( proposal_name.value ).packed_transaction ).expiration;
+      }
+      check( expiration < eosio::time_point_sec(current_time_point()), "cannot cancel until expiration" );
    }
-   proptable.erase(prop);
-
-   //remove from new table
-   approvals apptable( get_self(), proposer.value );
-   auto apps_it = apptable.find( proposal_name.value );
-   if ( apps_it != apptable.end() ) {
-      apptable.erase(apps_it);
-   } else {
-      old_approvals old_apptable( get_self(), proposer.value );
-      auto apps_it = old_apptable.find( proposal_name.value );
-      check( apps_it != old_apptable.end(), "proposal not found" );
-      old_apptable.erase(apps_it);
+   if ( exp_it != exp_idx.end() ) {
+      exp_idx.erase( exp_it );
    }
+   internal_use_do_not_use::db_remove_i64( prop_itr );
+
+   erase_approvals( proposer, proposal_name );
 }
 
 void multisig::exec( name proposer, name proposal_name, name executer ) {
@@ -149,31 +204,46 @@ void multisig::exec( name proposer, name proposal_name, name executer ) {
    ds >> trx_header;
    check( trx_header.expiration >= eosio::time_point_sec(current_time_point()), "transaction expired" );
 
+   invalidations inv_table( get_self(), get_self().value );
+   //approvals of the same actor are adjacent in sorted approval lists, so the last lookup is kept
+   name                      cached_actor;
+   std::optional<time_point> cached_invalidation;
+   auto last_invalidation = [&]( name actor ) -> const std::optional<time_point>& {
+      if ( actor != cached_actor ) {
+         auto it = inv_table.find( actor.value );
+         cached_actor        = actor;
+         cached_invalidation = it != inv_table.end() ? std::optional<time_point>( it->last_invalidation_time ) : std::nullopt;
+      }
+      return cached_invalidation;
+   };
+
    approvals apptable( get_self(), proposer.value );
    auto apps_it = apptable.find( proposal_name.value );
-   std::vector<permission_level> approvals;
-   invalidations inv_table( get_self(), get_self().value );
+   std::vector<char> packed_provided_approvals;
    if ( apps_it != apptable.end() ) {
+      std::vector<permission_level> approvals;
       approvals.reserve( apps_it->provided_approvals.size() );
       for ( auto& p : apps_it->provided_approvals ) {
-         auto it = inv_table.find( p.level.actor.value );
-         if ( it == inv_table.end() || it->last_invalidation_time < p.time ) {
+         const auto& inv = last_invalidation( p.level.actor );
+         if ( !inv || *inv < p.time ) {
             approvals.push_back(p.level);
          }
       }
+      packed_provided_approvals = pack(approvals);
       apptable.erase(apps_it);
    } else {
       old_approvals old_apptable( get_self(), proposer.value );
       auto& apps = old_apptable.get( proposal_name.value, "proposal not found" );
-      for ( auto& level : apps.provided_approvals ) {
-         auto it = inv_table.find( level.actor.value );
-         if ( it == inv_table.end() ) {
-            approvals.push_back( level );
-         }
+      auto is_invalidated = [&]( const permission_level& level ) { return bool( last_invalidation( level.actor ) ); };
+      if ( std::none_of( apps.provided_approvals.begin(), apps.provided_approvals.end(), is_invalidated ) ) {
+         packed_provided_approvals = pack(apps.provided_approvals);
+      } else {
+         std::vector<permission_level> approvals;
+         std::remove_copy_if( apps.provided_approvals.begin(), apps.provided_approvals.end(), std::back_inserter(approvals), is_invalidated );
+         packed_provided_approvals = pack(approvals);
       }
       old_apptable.erase(apps);
    }
-   auto packed_provided_approvals = pack(approvals);
    auto res =  check_transaction_authorization(
                   prop.packed_transaction.data(), prop.packed_transaction.size(),
                   (const char*)0, 0,
@@ -186,6 +256,25 @@ void multisig::exec( name proposer, name proposal_name, name executer ) {
                   prop.packed_transaction.data(), prop.packed_transaction.size() );
 
    proptable.erase(prop);
+   erase_expiration( proposer, proposal_name );
+}
+
+void multisig::migrate_approvals( approvals_info& info ) {
+   if ( info.version < 2 ) {
+      std::stable_sort( info.requested_approvals.begin(), info.requested_approvals.end(), approval_less );
+      std::stable_sort( info.provided_approvals.begin(), info.provided_approvals.end(), approval_less );
+      info.version = 2;
+   }
+}
+
+std::vector<multisig::approval>::iterator multisig::find_approval( std::vector<approval>& approvals, const permission_level& level ) {
+   auto itr = std::lower_bound( approvals.begin(), approvals.end(), level,
+                                []( const approval& a, const permission_level& l ) { return a.level < l; } );
+   return itr != approvals.end() && itr->level == level ? itr : approvals.end();
+}
+
+void multisig::insert_approval( std::vector<approval>& approvals, const approval& a ) {
+   approvals.insert( std::upper_bound( approvals.begin(), approvals.end(), a, approval_less ), a );
 }
 
 void multisig::invalidate( name account ) {
@@ -204,4 +293,45 @@ void multisig::invalidate( name account ) {
    }
 }
 
+void multisig::purge( uint16_t max ) {
+   check( max > 0, "max must be positive" );
+
+   const uint32_t now = eosio::time_point_sec(current_time_point()).sec_since_epoch();
+   proposal_expirations exptable( get_self(), get_self().value );
+   auto exp_idx = exptable.get_index<"byexpiration"_n>();
+   uint16_t purged = 0;
+   for ( auto exp_it = exp_idx.begin(); purged < max && exp_it != exp_idx.end() && exp_it->by_expiration() < now; ++purged ) {
+      const int32_t prop_itr = internal_use_do_not_use::db_find_i64( get_self().value, exp_it->proposer.value,
+                                                                     "proposal"_n.value, exp_it->proposal_name.value );
+      if ( prop_itr >= 0 ) {
+         internal_use_do_not_use::db_remove_i64( prop_itr );
+      }
+      erase_approvals( exp_it->proposer, exp_it->proposal_name );
+      exp_it = exp_idx.erase( exp_it );
+   }
+   check( purged > 0, "no expired proposals" );
+}
+
+void multisig::erase_approvals( name proposer, name proposal_name ) {
+   approvals apptable( get_self(), proposer.value );
+   auto apps_it = apptable.find( proposal_name.value );
+   if ( apps_it != apptable.end() ) {
+      apptable.erase(apps_it);
+   } else {
+      old_approvals old_apptable( get_self(), proposer.value );
+      auto apps_it = old_apptable.find( proposal_name.value );
+      check( apps_it != old_apptable.end(), "proposal not found" );
+      old_apptable.erase(apps_it);
+   }
+}
+
+void multisig::erase_expiration( name proposer, name proposal_name ) {
+   proposal_expirations exptable( get_self(), get_self().value );
+   auto exp_idx = exptable.get_index<"byproposal"_n>();
+   auto exp_it  = exp_idx.find( (uint128_t(proposer.value) << 64) | proposal_name.value );
+   if ( exp_it != exp_idx.end() ) {
+      exp_idx.erase( exp_it );
+   }
+}
+
 } /// namespace eosio
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace eosiosystem {
+
+   /**
+    * @addtogroup eosiosystem
+    * @{
+    */
+
+   /**
+    * Integer implementation of the bancor conversions used by `exchange_state`.
+    *
+    * All functions use 128-bit intermediate arithmetic and round toward zero, exactly like the
+    * `int64_t` truncation applied to the double precision results they replace. This header has
+    * no dependency on the contract libraries so it can also be compiled into native test code.
+    */
+   namespace bancor {
+
+      using int128  = __int128;
+      using uint128 = unsigned __int128;
+
+      /**
+       * Returns the number of significant bits of `n`.
+       */
+      inline int bit_width( uint128 n ) {
+         const uint64_t hi = uint64_t( n >> 64 );
+         if ( hi ) return 128 - __builtin_clzll( hi );
+         const uint64_t lo = uint64_t( n );
+         return lo ? 64 - __builtin_clzll( lo ) : 0;
+      }
+
+      /**
+       * Returns floor(sqrt(n)).
+       */
+      inline uint64_t isqrt( uint128 n ) {
+         if ( n == 0 ) return 0;
+
+         // start above the root; Newton's iteration then decreases monotonically to floor(sqrt(n))
+         uint128 x = uint128(1) << ( (bit_width( n ) + 1) / 2 );
+         while ( true ) {
+            const uint128 y = ( x + n / x ) >> 1;
+            if ( y >= x ) return uint64_t(x);
+            x = y;
+         }
+      }
+
+      /**
+       * Amount received when `inp` is sold into a constant product market holding `inp_reserve`
+       * and `out_reserve`: inp * out_reserve / (inp_reserve + inp).
+       */
+      inline int64_t get_output( int64_t inp_reserve, int64_t out_reserve, int64_t inp ) {
+         const int128 den = int128(inp_reserve) + inp;
+         if ( den == 0 ) return 0;
+
+         const int128 out = ( int128(inp) * out_reserve ) / den;
+         return out < 0 ? 0 : int64_t(out);
+      }
+
+      /**
+       * Amount that must be sold into a constant product market holding `out_reserve` and `inp_reserve`
+       * in order to receive `out`: inp_reserve * out / (out_reserve - out).
+       *
+       * Asking for the whole `out_reserve` or more has no finite price; the maximum int64_t is returned
+       * so that any asset built from it fails validation.
+       */
+      inline int64_t get_input( int64_t out_reserve, int64_t inp_reserve, int64_t out ) {
+         const int128 den = int128(out_reserve) - out;
+         if ( den <= 0 ) return std::numeric_limits<int64_t>::max();
+
+         const int128 inp = ( int128(inp_reserve) * out ) / den;
+         if ( inp < 0 ) return 0;
+         if ( inp > std::numeric_limits<int64_t>::max() ) return std::numeric_limits<int64_t>::max();
+         return int64_t(inp);
+      }
+
+      /**
+       * Smart tokens issued for `payment` deposited into a connector of weight 0.5:
+       * supply * ( sqrt(1 + payment / reserve) - 1 ), evaluated as
+       * supply * payment / ( reserve + sqrt(reserve * (reserve + payment)) ) to avoid cancellation.
+       */
+      inline int64_t half_weight_to_exchange( int64_t supply, int64_t reserve, int64_t payment ) {
+         if ( supply <= 0 || reserve <= 0 || payment <= 0 ) return 0;
+
+         // The square root is taken on the radicand scaled by 4^shift, using the headroom left in 128 bits,
+         // so that its truncation does not get amplified by supply / reserve.
+         const uint128 radicand = uint128(reserve) * ( uint128(reserve) + uint64_t(payment) );
+         const int     shift    = ( 127 - bit_width( radicand ) ) / 2;
+         const uint128 den      = ( uint128(reserve) << shift ) + isqrt( radicand << (2 * shift) );
+         const uint128 num      = uint128(supply) * uint64_t(payment);
+
+         const uint128 quo = num / den;
+         const uint128 rem = num % den;
+         return int64_t( ( quo << shift ) + ( rem << shift ) / den );
+      }
+
+      /**
+       * Connector tokens released when `tokens` smart tokens are returned to a connector of weight 0.5:
+       * reserve * ( 1 - (1 - tokens / supply)^2 ) = reserve * tokens * (2 * supply - tokens) / supply^2.
+       * The result is within 3 units below the exact value.
+       */
+      inline int64_t half_weight_from_exchange( int64_t supply, int64_t reserve, int64_t tokens ) {
+         if ( supply <= 0 || reserve <= 0 || tokens <= 0 ) return 0;
+         if ( tokens > supply ) tokens = supply;
+
+         const uint128 part = ( uint128(reserve) * uint64_t(tokens) ) / uint64_t(supply);
+         return int64_t( ( part * ( 2 * uint128(supply) - uint64_t(tokens) ) ) / uint64_t(supply) );
+      }
+
+      /**
+       * Applies the 0.5% ram fee on top of `cost`: cost / 0.995.
+       */
+      inline int64_t add_ram_fee( int64_t cost ) {
+         const int128 cost_plus_fee = ( int128(cost) * 1000 ) / 995;
+         if ( cost_plus_fee > std::numeric_limits<int64_t>::max() ) return std::numeric_limits<int64_t>::max();
+         return int64_t(cost_plus_fee);
+      }
+
+   } /// namespace bancor
+
+   /** @}*/ // end of @addtogroup eosiosystem
+} /// namespace eosiosystem
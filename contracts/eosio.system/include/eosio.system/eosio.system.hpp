@@ -121,6 +121,28 @@ namespace eosiosystem {
 
    typedef eosio::multi_index< "bidrefunds"_n, bid_refund > bid_refund_table;
 
+   // A bid refund ledger entry, which is defined by:
+   // - a unique `id`
+   // - the `bidder` account name owning the refund
+   // - the `newname` name the bidder was outbid on
+   // - the `amount` to be refunded, accumulated over all the times the bidder was outbid on `newname`
+   struct [[eosio::table, eosio::contract("eosio.system")]] bid_refund_entry {
+      uint64_t     id;
+      name         bidder;
+      name         newname;
+      asset        amount;
+
+      uint64_t  primary_key()const { return id; }
+      uint128_t by_bidder()const   { return (uint128_t(bidder.value) << 64) | newname.value; }
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( bid_refund_entry, (id)(bidder)(newname)(amount) )
+   };
+
+   typedef eosio::multi_index< "bidledger"_n, bid_refund_entry,
+                               indexed_by<"bybidder"_n, const_mem_fun<bid_refund_entry, uint128_t, &bid_refund_entry::by_bidder>>
+                             > bid_ledger_table;
+
    // Defines new global state parameters.
    struct [[eosio::table("global"), eosio::contract("eosio.system")]] eosio_global_state : eosio::blockchain_parameters {
       uint64_t free_ram()const { return max_ram_size - total_ram_bytes_reserved; }
@@ -167,8 +189,11 @@ namespace eosiosystem {
       eosio_global_state3() { }
       time_point        last_vpay_state_update;
       double            total_vpay_share_change_rate = 0;
+      // earliest time at which update_rex_pool has proceeds to distribute, cached here so that REX actions
+      // do not read the rex return pool tables before then; an absent value means it is unknown
+      eosio::binary_extension<time_point_sec> next_rex_dist_time;
 
-      EOSLIB_SERIALIZE( eosio_global_state3, (last_vpay_state_update)(total_vpay_share_change_rate) )
+      EOSLIB_SERIALIZE( eosio_global_state3, (last_vpay_state_update)(total_vpay_share_change_rate)(next_rex_dist_time) )
    };
 
    // Defines new global state parameters to store inflation rate and distribution
@@ -368,6 +393,25 @@ namespace eosiosystem {
    typedef eosio::multi_index< "delband"_n, delegated_bandwidth > del_bandwidth_table;
    typedef eosio::multi_index< "refunds"_n, refund_request >      refunds_table;
 
+   // A single entry of a `delegatebws` batch: tokens staked (positive) or unstaked (negative) for `receiver`.
+   struct bandwidth_delta {
+      name          receiver;
+      asset         net_delta;
+      asset         cpu_delta;
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( bandwidth_delta, (receiver)(net_delta)(cpu_delta) )
+   };
+
+   // A single entry of a `buyramfor` batch: `quant` core tokens of ram bought for `receiver`.
+   struct ram_purchase {
+      name          receiver;
+      asset         quant;
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( ram_purchase, (receiver)(quant) )
+   };
+
    // `rex_pool` structure underlying the rex pool table. A rex pool table entry is defined by:
    // - `version` defaulted to zero,
    // - `total_lent` total amount of CORE_SYMBOL in open rex_loans
@@ -522,6 +566,15 @@ namespace eosiosystem {
       asset stake_change;
    };
 
+   // Resource limits of an account as last read or written during the current action.
+   struct resource_limits_entry {
+      name     account;
+      int64_t  ram_bytes  = 0;
+      int64_t  net_weight = 0;
+      int64_t  cpu_weight = 0;
+      bool     modified   = false;
+   };
+
    /**
     * The EOSIO system contract. The EOSIO system contract governs ram market, voters, producers, global state.
     */
@@ -546,6 +599,8 @@ namespace eosiosystem {
          rex_fund_table           _rexfunds;
          rex_balance_table        _rexbalance;
          rex_order_table          _rexorders;
+         // written back to the chain once per account in the destructor
+         std::vector<resource_limits_entry> _resource_limits;
 
       public:
          static constexpr eosio::name active_permission{"active"_n};
@@ -904,6 +959,28 @@ namespace eosiosystem {
          [[eosio::action]]
          void closerex( const name& owner );
 
+         /**
+          * Quoterex action, quotes a REX trade against the current REX pool without changing any state.
+          * The quote is computed by the same code as `buyrex` and `sellrex` and is reported by the
+          * inline `quoteresult` action of `rex.results`.
+          *
+          * @param quantity - core tokens to buy REX with, or REX tokens to sell.
+          *
+          * @post Quote does not account for the REX pool being unable to fill a sell order at this time.
+          */
+         [[eosio::action]]
+         void quoterex( const asset& quantity );
+
+         /**
+          * Quoteloan action, quotes the amount of tokens rented to a new CPU or NET loan against the current
+          * REX pool without changing any state. The quote is computed by the same code as `rentcpu` and
+          * `rentnet` and is reported by the inline `quoteresult` action of `rex.results`.
+          *
+          * @param loan_payment - tokens to be paid for the loan.
+          */
+         [[eosio::action]]
+         void quoteloan( const asset& loan_payment );
+
          /**
           * Undelegate bandwitdh action, decreases the total tokens delegated by `from` to `receiver` and/or
           * frees the memory associated with the delegation if there is nothing
@@ -935,6 +1012,21 @@ namespace eosiosystem {
          void undelegatebw( const name& from, const name& receiver,
                             const asset& unstake_net_quantity, const asset& unstake_cpu_quantity );
 
+         /**
+          * Delegate bandwidth to many receivers action. Applies each delta in order, exactly as a sequence of
+          * `delegatebw` (positive deltas) and `undelegatebw` (negative deltas) actions without transfer would,
+          * but tokens newly staked are transfered once and the vote weight of `from` is updated once for
+          * the whole batch.
+          *
+          * @param from - the account whose tokens are staked or unstaked,
+          * @param deltas - for each receiver, the change in tokens staked for NET and CPU bandwidth;
+          *    NET and CPU changes of a receiver cannot have opposite signs.
+          *
+          * @post All producers `from` account has voted for will have their votes updated immediately.
+          */
+         [[eosio::action]]
+         void delegatebws( const name& from, const std::vector<bandwidth_delta>& deltas );
+
          /**
           * Buy ram action, increases receiver's ram quota based upon current price and quantity of
           * tokens provided. An inline transfer from receiver to system contract of
@@ -958,6 +1050,17 @@ namespace eosiosystem {
          [[eosio::action]]
          void buyrambytes( const name& payer, const name& receiver, uint32_t bytes );
 
+         /**
+          * Buy ram for many receivers action. Each purchase is priced in order, exactly as a sequence of
+          * `buyram` actions would be, but the ram market is updated once and the payer is billed with a
+          * single payment transfer and a single fee transfer for the whole batch.
+          *
+          * @param payer - the ram buyer,
+          * @param purchases - the list of receivers and the quantity of tokens to buy ram with for each of them.
+          */
+         [[eosio::action]]
+         void buyramfor( const name& payer, const std::vector<ram_purchase>& purchases );
+
          /**
           * Sell ram action, reduces quota by bytes and then performs an inline transfer of tokens
           * to receiver based upon the average purchase price of the original quota.
@@ -968,6 +1071,17 @@ namespace eosiosystem {
          [[eosio::action]]
          void sellram( const name& account, int64_t bytes );
 
+         /**
+          * Quote ram action, quotes a ram trade against the current ram market without changing any state.
+          * The quote is computed by the same code as `buyram` and `sellram`, fees included, and is reported
+          * by the inline `quoteresult` action of `rex.results`.
+          *
+          * @param quantity - core tokens to buy ram with, quoted in RAM bytes, or RAM bytes to sell,
+          *    quoted in core tokens.
+          */
+         [[eosio::action]]
+         void quoteram( const asset& quantity );
+
          /**
           * Refund action, this action is called after the delegation-period to claim all pending
           * unstaked tokens belonging to owner.
@@ -977,6 +1091,18 @@ namespace eosiosystem {
          [[eosio::action]]
          void refund( const name& owner );
 
+         /**
+          * Process refunds action, pays out the refund requests of `owners` whose delegation-period has elapsed.
+          * Owners without a matured refund request are skipped. Any account can execute this action. Refunds are
+          * not paid out automatically; they are paid by this action or claimed by their owner with `refund`.
+          *
+          * @param owners - the owners whose refunds are paid out.
+          *
+          * @pre At least one of `owners` has a matured refund request.
+          */
+         [[eosio::action]]
+         void procrefunds( const std::vector<name>& owners );
+
          // functions defined in voting.cpp
 
          /**
@@ -1139,7 +1265,8 @@ namespace eosiosystem {
          void bidname( const name& bidder, const name& newname, const asset& bid );
 
          /**
-          * Bid refund action, allows the account `bidder` to get back the amount it bid so far on a `newname` name.
+          * Bid refund action, allows the account `bidder` to get back the amount it bid so far on a `newname` name,
+          * for bids outbid before the bid refund ledger was introduced.
           *
           * @param bidder - the account that gets refunded,
           * @param newname - the name for which the bid was placed and now it gets refunded for.
@@ -1147,6 +1274,15 @@ namespace eosiosystem {
          [[eosio::action]]
          void bidrefund( const name& bidder, const name& newname );
 
+         /**
+          * Claim bid refunds action, allows the account `bidder` to get back, in a single transfer, the amounts
+          * it bid on all the names it has been outbid on.
+          *
+          * @param bidder - the account that gets refunded.
+          */
+         [[eosio::action]]
+         void claimbidrefs( const name& bidder );
+
          /**
           * Change the annual inflation rate of the core token supply and specify how
           * the new issued tokens will be distributed based on the following structure.
@@ -1191,11 +1327,17 @@ namespace eosiosystem {
          using mvfrsavings_action = eosio::action_wrapper<"mvfrsavings"_n, &system_contract::mvfrsavings>;
          using consolidate_action = eosio::action_wrapper<"consolidate"_n, &system_contract::consolidate>;
          using closerex_action = eosio::action_wrapper<"closerex"_n, &system_contract::closerex>;
+         using quoterex_action = eosio::action_wrapper<"quoterex"_n, &system_contract::quoterex>;
+         using quoteloan_action = eosio::action_wrapper<"quoteloan"_n, &system_contract::quoteloan>;
          using undelegatebw_action = eosio::action_wrapper<"undelegatebw"_n, &system_contract::undelegatebw>;
+         using delegatebws_action = eosio::action_wrapper<"delegatebws"_n, &system_contract::delegatebws>;
          using buyram_action = eosio::action_wrapper<"buyram"_n, &system_contract::buyram>;
          using buyrambytes_action = eosio::action_wrapper<"buyrambytes"_n, &system_contract::buyrambytes>;
+         using buyramfor_action = eosio::action_wrapper<"buyramfor"_n, &system_contract::buyramfor>;
          using sellram_action = eosio::action_wrapper<"sellram"_n, &system_contract::sellram>;
+         using quoteram_action = eosio::action_wrapper<"quoteram"_n, &system_contract::quoteram>;
          using refund_action = eosio::action_wrapper<"refund"_n, &system_contract::refund>;
+         using procrefunds_action = eosio::action_wrapper<"procrefunds"_n, &system_contract::procrefunds>;
          using regproducer_action = eosio::action_wrapper<"regproducer"_n, &system_contract::regproducer>;
          using regproducer2_action = eosio::action_wrapper<"regproducer2"_n, &system_contract::regproducer2>;
          using unregprod_action = eosio::action_wrapper<"unregprod"_n, &system_contract::unregprod>;
@@ -1208,6 +1350,7 @@ namespace eosiosystem {
          using updtrevision_action = eosio::action_wrapper<"updtrevision"_n, &system_contract::updtrevision>;
          using bidname_action = eosio::action_wrapper<"bidname"_n, &system_contract::bidname>;
          using bidrefund_action = eosio::action_wrapper<"bidrefund"_n, &system_contract::bidrefund>;
+         using claimbidrefs_action = eosio::action_wrapper<"claimbidrefs"_n, &system_contract::claimbidrefs>;
          using setpriv_action = eosio::action_wrapper<"setpriv"_n, &system_contract::setpriv>;
          using setalimits_action = eosio::action_wrapper<"setalimits"_n, &system_contract::setalimits>;
          using setparams_action = eosio::action_wrapper<"setparams"_n, &system_contract::setparams>;
@@ -1227,11 +1370,22 @@ namespace eosiosystem {
          static eosio_global_state4 get_default_inflation_parameters();
          symbol core_symbol()const;
          void update_ram_supply();
+         int64_t get_ram_supply_increase()const;
+         void get_account_limits( const name& account, int64_t& ram_bytes, int64_t& net_weight, int64_t& cpu_weight );
+         void set_account_limits( const name& account, int64_t ram_bytes, int64_t net_weight, int64_t cpu_weight );
+         resource_limits_entry& find_account_limits( const name& account, bool read );
 
          // defined in rex.cpp
          void runrex( uint16_t max );
          void update_rex_pool();
          void update_resource_limits( const name& from, const name& receiver, int64_t delta_net, int64_t delta_cpu );
+         rex_pool get_accrued_rex_pool()const;
+         int64_t get_rex_received( const asset& payment )const;
+         int64_t get_rex_received( const asset& payment, const rex_pool& pool )const;
+         int64_t get_rex_proceeds( const asset& rex )const;
+         int64_t get_rex_proceeds( const asset& rex, const rex_pool& pool )const;
+         int64_t get_rented_tokens( const asset& payment )const;
+         int64_t get_rented_tokens( const asset& payment, const rex_pool& pool )const;
          void check_voting_requirement( const name& owner,
                                         const char* error_msg = "must vote for at least 21 producers or for a proxy before buying REX" )const;
          rex_order_outcome fill_rex_order( const rex_balance_table::const_iterator& bitr, const asset& rex );
@@ -1268,7 +1422,11 @@ namespace eosiosystem {
          // defined in delegate_bandwidth.cpp
          void changebw( name from, const name& receiver,
                         const asset& stake_net_quantity, const asset& stake_cpu_quantity, bool transfer );
+         asset update_delegated_bw( const name& from, const name& receiver, const name& source_stake_from,
+                                    const asset& stake_net_delta, const asset& stake_cpu_delta, bool transfer );
+         bool pay_refund( const name& owner, const std::vector<permission_level>& auths );
          void update_voting_power( const name& voter, const asset& total_update );
+         void add_ram_bytes( const name& receiver, int64_t bytes );
 
          // defined in voting.cpp
          void register_producer( const name& producer, const eosio::block_signing_authority& producer_authority, const std::string& url, uint16_t location );
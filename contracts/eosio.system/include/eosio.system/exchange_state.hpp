@@ -3,6 +3,16 @@
 #include <eosio/asset.hpp>
 #include <eosio/multi_index.hpp>
 
+#include <eosio.system/bancor.hpp>
+
+// EXCHANGE_STATE_FIXED_POINT macro selects the arithmetic used by the bancor conversions of exchange_state.
+// When set to 1, conversions are computed with 128-bit integer arithmetic (see bancor.hpp) instead of double
+// precision floating point, avoiding softfloat division and pow in WASM. Integer results can differ from the
+// floating point ones in the last unit, so all nodes of a chain must run a contract built with the same setting.
+#ifndef EXCHANGE_STATE_FIXED_POINT
+#define EXCHANGE_STATE_FIXED_POINT 0
+#endif
+
 namespace eosiosystem {
 
    using eosio::asset;
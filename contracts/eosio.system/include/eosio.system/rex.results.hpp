@@ -9,8 +9,9 @@ using eosio::asset;
 using eosio::name;
 
 /**
- * The actions `buyresult`, `sellresult`, `rentresult`, and `orderresult` of `rex.results` are all no-ops. 
- * They are added as inline convenience actions to `rentnet`, `rentcpu`, `buyrex`, `unstaketorex`, and `sellrex`. 
+ * The actions `buyresult`, `sellresult`, `rentresult`, `orderresult`, and `quoteresult` of `rex.results` are all no-ops. 
+ * They are added as inline convenience actions to `rentnet`, `rentcpu`, `buyrex`, `unstaketorex`, `sellrex`,
+ * `quoterex`, `quoteram`, and `quoteloan`. 
  * An inline convenience action does not have any effect, however, 
  * its data includes the result of the parent action and appears in its trace.
  */
@@ -52,8 +53,18 @@ class [[eosio::contract("rex.results")]] rex_results : eosio::contract {
       [[eosio::action]]
       void rentresult( const asset& rented_tokens );
 
+      /**
+       * Quoteresult action.
+       *
+       * @param quantity - quantity that was quoted
+       * @param quote - amount of tokens or ram bytes that would be received for quantity
+       */
+      [[eosio::action]]
+      void quoteresult( const asset& quantity, const asset& quote );
+
       using buyresult_action   = action_wrapper<"buyresult"_n,   &rex_results::buyresult>;
       using sellresult_action  = action_wrapper<"sellresult"_n,  &rex_results::sellresult>;
       using orderresult_action = action_wrapper<"orderresult"_n, &rex_results::orderresult>;
       using rentresult_action  = action_wrapper<"rentresult"_n,  &rex_results::rentresult>;
+      using quoteresult_action = action_wrapper<"quoteresult"_n, &rex_results::quoteresult>;
 };
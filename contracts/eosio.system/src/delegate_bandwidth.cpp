@@ -6,6 +6,7 @@
 #include <eosio/transaction.hpp>
 
 #include <eosio.system/eosio.system.hpp>
+#include <eosio.system/rex.results.hpp>
 #include <eosio.token/eosio.token.hpp>
 
 #include "name_bidding.cpp"
@@ -30,7 +31,11 @@ namespace eosiosystem {
       const int64_t ram_reserve   = itr->base.balance.amount;
       const int64_t eos_reserve   = itr->quote.balance.amount;
       const int64_t cost          = exchange_state::get_bancor_input( ram_reserve, eos_reserve, bytes );
+#if EXCHANGE_STATE_FIXED_POINT
+      const int64_t cost_plus_fee = bancor::add_ram_fee( cost );
+#else
       const int64_t cost_plus_fee = cost / double(0.995);
+#endif
       buyram( payer, receiver, asset{ cost_plus_fee, core_symbol() } );
    }
 
@@ -82,6 +87,75 @@ namespace eosiosystem {
       _gstate.total_ram_bytes_reserved += uint64_t(bytes_out);
       _gstate.total_ram_stake          += quant_after_fee.amount;
 
+      add_ram_bytes( receiver, bytes_out );
+   }
+
+   /**
+    *  Prices every purchase against an in-memory copy of the ram market, in order, so the result is the
+    *  same as a sequence of buyram actions while `_rammarket` is written once and the payer only pays
+    *  one "buy ram" and one "ram fee" transfer for the whole batch.
+    */
+   void system_contract::buyramfor( const name& payer, const std::vector<ram_purchase>& purchases )
+   {
+      require_auth( payer );
+      update_ram_supply();
+
+      check( !purchases.empty(), "no ram purchases provided" );
+
+      const auto& market = _rammarket.get(ramcore_symbol.raw(), "ram market does not exist");
+      exchange_state es = market;
+
+      asset   total_after_fee( 0, core_symbol() );
+      asset   total_fee( 0, core_symbol() );
+      int64_t total_bytes_out = 0;
+      std::vector<int64_t> bytes_out;
+      bytes_out.reserve( purchases.size() );
+
+      for ( const auto& p : purchases ) {
+         check( p.quant.symbol == core_symbol(), "must buy ram with core token" );
+         check( p.quant.amount > 0, "must purchase a positive amount" );
+
+         // same rounding as buyram, applied to each purchase
+         auto fee = p.quant;
+         fee.amount = ( fee.amount + 199 ) / 200; /// .5% fee (round up)
+         auto quant_after_fee = p.quant;
+         quant_after_fee.amount -= fee.amount;
+
+         const int64_t out = es.direct_convert( quant_after_fee, ram_symbol ).amount;
+         check( out > 0, "must reserve a positive amount" );
+
+         total_after_fee += quant_after_fee;
+         total_fee       += fee;
+         total_bytes_out += out;
+         bytes_out.push_back( out );
+      }
+
+      {
+         token::transfer_action transfer_act{ token_account, { {payer, active_permission}, {ram_account, active_permission} } };
+         transfer_act.send( payer, ram_account, total_after_fee, "buy ram" );
+      }
+      {
+         token::transfer_action transfer_act{ token_account, { {payer, active_permission} } };
+         transfer_act.send( payer, ramfee_account, total_fee, "ram fee" );
+         channel_to_rex( ramfee_account, total_fee );
+      }
+
+      _rammarket.modify( market, same_payer, [&]( auto& m ) {
+         m.supply = es.supply;
+         m.base   = es.base;
+         m.quote  = es.quote;
+      });
+
+      _gstate.total_ram_bytes_reserved += uint64_t(total_bytes_out);
+      _gstate.total_ram_stake          += total_after_fee.amount;
+
+      for ( size_t i = 0; i < purchases.size(); ++i ) {
+         add_ram_bytes( purchases[i].receiver, bytes_out[i] );
+      }
+   }
+
+   void system_contract::add_ram_bytes( const name& receiver, int64_t bytes )
+   {
       user_resources_table  userres( get_self(), receiver.value );
       auto res_itr = userres.find( receiver.value );
       if( res_itr ==  userres.end() ) {
@@ -89,19 +163,19 @@ namespace eosiosystem {
                res.owner = receiver;
                res.net_weight = asset( 0, core_symbol() );
                res.cpu_weight = asset( 0, core_symbol() );
-               res.ram_bytes = bytes_out;
+               res.ram_bytes = bytes;
             });
       } else {
          userres.modify( res_itr, receiver, [&]( auto& res ) {
-               res.ram_bytes += bytes_out;
+               res.ram_bytes += bytes;
             });
       }
 
       auto voter_itr = _voters.find( res_itr->owner.value );
       if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed ) ) {
          int64_t ram_bytes, net, cpu;
-         get_resource_limits( res_itr->owner, ram_bytes, net, cpu );
-         set_resource_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
+         get_account_limits( res_itr->owner, ram_bytes, net, cpu );
+         set_account_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
       }
    }
 
@@ -144,8 +218,8 @@ namespace eosiosystem {
       auto voter_itr = _voters.find( res_itr->owner.value );
       if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed ) ) {
          int64_t ram_bytes, net, cpu;
-         get_resource_limits( res_itr->owner, ram_bytes, net, cpu );
-         set_resource_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
+         get_account_limits( res_itr->owner, ram_bytes, net, cpu );
+         set_account_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
       }
 
       {
@@ -161,6 +235,32 @@ namespace eosiosystem {
       }
    }
 
+   void system_contract::quoteram( const asset& quantity ) {
+      exchange_state es = _rammarket.get(ramcore_symbol.raw(), "ram market does not exist");
+      /// ram that update_ram_supply would add to the market before the trade
+      es.base.balance.amount += get_ram_supply_increase();
+
+      asset quote;
+      if ( quantity.symbol == ram_symbol ) {
+         check( quantity.amount > 0, "cannot sell negative byte" );
+         const asset tokens_out = es.direct_convert( quantity, core_symbol() );
+         /// same checks as sellram and buyram, so that no quote is given for a trade they would reject
+         check( tokens_out.amount > 1, "token amount received from selling ram is too low" );
+         const auto  fee        = ( tokens_out.amount + 199 ) / 200; /// .5% fee (round up)
+         quote = asset( tokens_out.amount - fee, core_symbol() );
+      } else {
+         check( quantity.symbol == core_symbol(), "must quote ram with core token or RAM bytes" );
+         check( quantity.amount > 0, "must purchase a positive amount" );
+         auto quant_after_fee = quantity;
+         quant_after_fee.amount -= ( quantity.amount + 199 ) / 200; /// .5% fee (round up)
+         quote = es.direct_convert( quant_after_fee, ram_symbol );
+         check( quote.amount > 0, "must reserve a positive amount" );
+      }
+      // dummy action added so that the quote shows up in action trace
+      rex_results::quoteresult_action quoteresult_act( rex_account, std::vector<eosio::permission_level>{ } );
+      quoteresult_act.send( quantity, quote );
+   }
+
    void validate_b1_vesting( int64_t stake ) {
       const int64_t base_time = 1527811200; /// 2018-06-01
       const int64_t max_claimable = 100'000'000'0000ll;
@@ -173,16 +273,37 @@ namespace eosiosystem {
                                    const asset& stake_net_delta, const asset& stake_cpu_delta, bool transfer )
    {
       require_auth( from );
-      check( stake_net_delta.amount != 0 || stake_cpu_delta.amount != 0, "should stake non-zero amount" );
-      check( std::abs( (stake_net_delta + stake_cpu_delta).amount )
-             >= std::max( std::abs( stake_net_delta.amount ), std::abs( stake_cpu_delta.amount ) ),
-             "net and cpu deltas cannot be opposite signs" );
 
       name source_stake_from = from;
       if ( transfer ) {
          from = receiver;
       }
 
+      auto transfer_amount = update_delegated_bw( from, receiver, source_stake_from, stake_net_delta, stake_cpu_delta, transfer );
+      if ( 0 < transfer_amount.amount ) {
+         token::transfer_action transfer_act{ token_account, { {source_stake_from, active_permission} } };
+         transfer_act.send( source_stake_from, stake_account, asset(transfer_amount), "stake bandwidth" );
+      }
+
+      vote_stake_updater( from );
+      update_voting_power( from, stake_net_delta + stake_cpu_delta );
+   }
+
+   /**
+    *  Updates the delegation from `from` to `receiver`, the resources of `receiver` and the refund request of
+    *  `from`, and returns the amount of tokens `source_stake_from` has to transfer to the stake account.
+    *  The vote weight of `from` is left to the caller.
+    */
+   asset system_contract::update_delegated_bw( const name& from, const name& receiver, const name& source_stake_from,
+                                               const asset& stake_net_delta, const asset& stake_cpu_delta, bool transfer )
+   {
+      check( stake_net_delta.amount != 0 || stake_cpu_delta.amount != 0, "should stake non-zero amount" );
+      check( std::abs( (stake_net_delta + stake_cpu_delta).amount )
+             >= std::max( std::abs( stake_net_delta.amount ), std::abs( stake_cpu_delta.amount ) ),
+             "net and cpu deltas cannot be opposite signs" );
+
+      asset transfer_amount( 0, core_symbol() );
+
       // update stake delegated from "from" to "receiver"
       {
          del_bandwidth_table     del_tbl( get_self(), from.value );
@@ -241,9 +362,9 @@ namespace eosiosystem {
 
             if( !(net_managed && cpu_managed) ) {
                int64_t ram_bytes, net, cpu;
-               get_resource_limits( receiver, ram_bytes, net, cpu );
+               get_account_limits( receiver, ram_bytes, net, cpu );
 
-               set_resource_limits( receiver,
+               set_account_limits( receiver,
                                     ram_managed ? ram_bytes : std::max( tot_itr->ram_bytes + ram_gift_bytes, ram_bytes ),
                                     net_managed ? net : tot_itr->net_weight.amount,
                                     cpu_managed ? cpu : tot_itr->cpu_weight.amount );
@@ -259,11 +380,12 @@ namespace eosiosystem {
       if ( stake_account != source_stake_from ) { //for eosio both transfer and refund make no sense
          refunds_table refunds_tbl( get_self(), from.value );
          auto req = refunds_tbl.find( from.value );
+         // refunds requested before refunds became claimable were scheduled as deferred transactions
+         const bool had_refund = req != refunds_tbl.end();
 
          //create/update/delete refund
          auto net_balance = stake_net_delta;
          auto cpu_balance = stake_cpu_delta;
-         bool need_deferred_trx = false;
 
 
          // net and cpu are same sign by assertions in delegatebw and undelegatebw
@@ -298,9 +420,6 @@ namespace eosiosystem {
 
                if ( req->is_empty() ) {
                   refunds_tbl.erase( req );
-                  need_deferred_trx = false;
-               } else {
-                  need_deferred_trx = true;
                }
             } else if ( net_balance.amount < 0 || cpu_balance.amount < 0 ) { //need to create refund
                refunds_tbl.emplace( from, [&]( refund_request& r ) {
@@ -319,32 +438,17 @@ namespace eosiosystem {
                   }
                   r.request_time = current_time_point();
                });
-               need_deferred_trx = true;
             } // else stake increase requested with no existing row in refunds_tbl -> nothing to do with refunds_tbl
          } /// end if is_delegating_to_self || is_undelegating
 
-         if ( need_deferred_trx ) {
-            eosio::transaction out;
-            out.actions.emplace_back( permission_level{from, active_permission},
-                                      get_self(), "refund"_n,
-                                      from
-            );
-            out.delay_sec = refund_delay_sec;
-            eosio::cancel_deferred( from.value ); // TODO: Remove this line when replacing deferred trxs is fixed
-            out.send( from.value, from, true );
-         } else {
+         if ( had_refund ) {
             eosio::cancel_deferred( from.value );
          }
 
-         auto transfer_amount = net_balance + cpu_balance;
-         if ( 0 < transfer_amount.amount ) {
-            token::transfer_action transfer_act{ token_account, { {source_stake_from, active_permission} } };
-            transfer_act.send( source_stake_from, stake_account, asset(transfer_amount), "stake bandwidth" );
-         }
+         transfer_amount = net_balance + cpu_balance;
       }
 
-      vote_stake_updater( from );
-      update_voting_power( from, stake_net_delta + stake_cpu_delta );
+      return transfer_amount;
    }
 
    void system_contract::update_voting_power( const name& voter, const asset& total_update )
@@ -399,6 +503,35 @@ namespace eosiosystem {
    } // undelegatebw
 
 
+   void system_contract::delegatebws( const name& from, const std::vector<bandwidth_delta>& deltas )
+   {
+      require_auth( from );
+      check( !deltas.empty(), "no bandwidth changes provided" );
+
+      asset total_delta( 0, core_symbol() );
+      asset total_transfer( 0, core_symbol() );
+      for ( const auto& d : deltas ) {
+         check( d.net_delta.symbol == core_symbol() && d.cpu_delta.symbol == core_symbol(), "must use core token" );
+         if ( d.net_delta.amount < 0 || d.cpu_delta.amount < 0 ) {
+            check( _gstate.thresh_activated_stake_time != time_point(),
+                   "cannot undelegate bandwidth until the chain is activated (at least 15% of all tokens participate in voting)" );
+         }
+         const auto transfer_amount = update_delegated_bw( from, d.receiver, from, d.net_delta, d.cpu_delta, false );
+         if ( 0 < transfer_amount.amount ) {
+            total_transfer += transfer_amount;
+         }
+         total_delta += d.net_delta + d.cpu_delta;
+      }
+
+      if ( 0 < total_transfer.amount ) {
+         token::transfer_action transfer_act{ token_account, { {from, active_permission} } };
+         transfer_act.send( from, stake_account, total_transfer, "stake bandwidth" );
+      }
+
+      vote_stake_updater( from );
+      update_voting_power( from, total_delta );
+   }
+
    void system_contract::refund( const name& owner ) {
       require_auth( owner );
 
@@ -407,9 +540,35 @@ namespace eosiosystem {
       check( req != refunds_tbl.end(), "refund request not found" );
       check( req->request_time + seconds(refund_delay_sec) <= current_time_point(),
              "refund is not available yet" );
-      token::transfer_action transfer_act{ token_account, { {stake_account, active_permission}, {req->owner, active_permission} } };
+      pay_refund( owner, { {stake_account, active_permission}, {owner, active_permission} } );
+   }
+
+   void system_contract::procrefunds( const std::vector<name>& owners ) {
+      uint32_t paid = 0;
+      for ( const auto& owner : owners ) {
+         if ( pay_refund( owner, { {stake_account, active_permission} } ) ) {
+            ++paid;
+         }
+      }
+      check( 0 < paid, "no refunds available" );
+   }
+
+   /**
+    *  Pays out the refund request of `owner` if its delegation-period has elapsed and returns whether it was paid.
+    *  Refunds are only paid for the owners an action names, so an owner whose notification handler rejects the
+    *  transfer can only fail the actions that name it and never holds up the refunds of other owners.
+    */
+   bool system_contract::pay_refund( const name& owner, const std::vector<permission_level>& auths ) {
+      refunds_table refunds_tbl( get_self(), owner.value );
+      auto req = refunds_tbl.find( owner.value );
+      if ( req == refunds_tbl.end() || current_time_point() < req->request_time + seconds(refund_delay_sec) ) {
+         return false;
+      }
+
+      token::transfer_action transfer_act{ token_account, auths };
       transfer_act.send( stake_account, req->owner, req->net_amount + req->cpu_amount, "unstake" );
       refunds_tbl.erase( req );
+      return true;
    }
 
 
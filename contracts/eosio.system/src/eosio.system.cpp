@@ -62,6 +62,45 @@ namespace eosiosystem {
       _global2.set( _gstate2, get_self() );
       _global3.set( _gstate3, get_self() );
       _global4.set( _gstate4, get_self() );
+
+      for ( const auto& l : _resource_limits ) {
+         if ( l.modified ) {
+            set_resource_limits( l.account, l.ram_bytes, l.net_weight, l.cpu_weight );
+         }
+      }
+   }
+
+   /**
+    *  Resource limits are read from the chain at most once per account and action; changes are kept
+    *  in `_resource_limits` and written back once per account in the destructor.
+    */
+   resource_limits_entry& system_contract::find_account_limits( const name& account, bool read ) {
+      for ( auto& l : _resource_limits ) {
+         if ( l.account == account ) {
+            return l;
+         }
+      }
+      auto& l = _resource_limits.emplace_back();
+      l.account = account;
+      if ( read ) {
+         get_resource_limits( account, l.ram_bytes, l.net_weight, l.cpu_weight );
+      }
+      return l;
+   }
+
+   void system_contract::get_account_limits( const name& account, int64_t& ram_bytes, int64_t& net_weight, int64_t& cpu_weight ) {
+      const auto& l = find_account_limits( account, true );
+      ram_bytes  = l.ram_bytes;
+      net_weight = l.net_weight;
+      cpu_weight = l.cpu_weight;
+   }
+
+   void system_contract::set_account_limits( const name& account, int64_t ram_bytes, int64_t net_weight, int64_t cpu_weight ) {
+      auto& l = find_account_limits( account, false );
+      l.ram_bytes  = ram_bytes;
+      l.net_weight = net_weight;
+      l.cpu_weight = cpu_weight;
+      l.modified   = true;
    }
 
    void system_contract::setram( uint64_t max_ram_size ) {
@@ -90,7 +129,7 @@ namespace eosiosystem {
       if( cbt <= _gstate2.last_ram_increase ) return;
 
       auto itr = _rammarket.find(ramcore_symbol.raw());
-      auto new_ram = (cbt.slot - _gstate2.last_ram_increase.slot)*_gstate2.new_ram_per_block;
+      auto new_ram = get_ram_supply_increase();
       _gstate.max_ram_size += new_ram;
 
       /**
@@ -102,6 +141,17 @@ namespace eosiosystem {
       _gstate2.last_ram_increase = cbt;
    }
 
+   /**
+    *  Ram added to the market by update_ram_supply if it is called in the current block.
+    */
+   int64_t system_contract::get_ram_supply_increase()const {
+      auto cbt = eosio::current_block_time();
+
+      if( cbt <= _gstate2.last_ram_increase ) return 0;
+
+      return (cbt.slot - _gstate2.last_ram_increase.slot)*_gstate2.new_ram_per_block;
+   }
+
    void system_contract::setramrate( uint16_t bytes_per_block ) {
       require_auth( get_self() );
 
@@ -136,14 +186,14 @@ namespace eosiosystem {
          check( !(ram_managed || net_managed || cpu_managed), "cannot use setalimits on an account with managed resources" );
       }
 
-      set_resource_limits( account, ram, net, cpu );
+      set_account_limits( account, ram, net, cpu );
    }
 
    void system_contract::setacctram( const name& account, const std::optional<int64_t>& ram_bytes ) {
       require_auth( get_self() );
 
       int64_t current_ram, current_net, current_cpu;
-      get_resource_limits( account, current_ram, current_net, current_cpu );
+      get_account_limits( account, current_ram, current_net, current_cpu );
 
       int64_t ram = 0;
 
@@ -181,14 +231,14 @@ namespace eosiosystem {
          ram = *ram_bytes;
       }
 
-      set_resource_limits( account, ram, current_net, current_cpu );
+      set_account_limits( account, ram, current_net, current_cpu );
    }
 
    void system_contract::setacctnet( const name& account, const std::optional<int64_t>& net_weight ) {
       require_auth( get_self() );
 
       int64_t current_ram, current_net, current_cpu;
-      get_resource_limits( account, current_ram, current_net, current_cpu );
+      get_account_limits( account, current_ram, current_net, current_cpu );
 
       int64_t net = 0;
 
@@ -225,14 +275,14 @@ namespace eosiosystem {
          net = *net_weight;
       }
 
-      set_resource_limits( account, current_ram, net, current_cpu );
+      set_account_limits( account, current_ram, net, current_cpu );
    }
 
    void system_contract::setacctcpu( const name& account, const std::optional<int64_t>& cpu_weight ) {
       require_auth( get_self() );
 
       int64_t current_ram, current_net, current_cpu;
-      get_resource_limits( account, current_ram, current_net, current_cpu );
+      get_account_limits( account, current_ram, current_net, current_cpu );
 
       int64_t cpu = 0;
 
@@ -269,7 +319,7 @@ namespace eosiosystem {
          cpu = *cpu_weight;
       }
 
-      set_resource_limits( account, current_ram, current_net, cpu );
+      set_account_limits( account, current_ram, current_net, cpu );
    }
 
    void system_contract::activate( const eosio::checksum256& feature_digest ) {
@@ -10,6 +10,14 @@ namespace eosiosystem {
 
    asset exchange_state::convert_to_exchange( connector& reserve, const asset& payment )
    {
+#if EXCHANGE_STATE_FIXED_POINT
+      if ( reserve.weight == .5 ) {
+         const int64_t dS = bancor::half_weight_to_exchange( supply.amount, reserve.balance.amount, payment.amount );
+         reserve.balance += payment;
+         supply.amount   += dS;
+         return asset( dS, supply.symbol );
+      }
+#endif
       const double S0 = supply.amount;
       const double R0 = reserve.balance.amount;
       const double dR = payment.amount;
@@ -24,6 +32,14 @@ namespace eosiosystem {
 
    asset exchange_state::convert_from_exchange( connector& reserve, const asset& tokens )
    {
+#if EXCHANGE_STATE_FIXED_POINT
+      if ( reserve.weight == .5 ) {
+         const int64_t dR = bancor::half_weight_from_exchange( supply.amount, reserve.balance.amount, tokens.amount );
+         reserve.balance.amount -= dR;
+         supply                 -= tokens;
+         return asset( dR, reserve.balance.symbol );
+      }
+#endif
       const double R0 = reserve.balance.amount;
       const double S0 = supply.amount;
       const double dS = -tokens.amount; // dS < 0, tokens are subtracted from supply
@@ -82,6 +98,9 @@ namespace eosiosystem {
                                               int64_t out_reserve,
                                               int64_t inp )
    {
+#if EXCHANGE_STATE_FIXED_POINT
+      return bancor::get_output( inp_reserve, out_reserve, inp );
+#else
       const double ib = inp_reserve;
       const double ob = out_reserve;
       const double in = inp;
@@ -91,12 +110,16 @@ namespace eosiosystem {
       if ( out < 0 ) out = 0;
 
       return out;
+#endif
    }
 
    int64_t exchange_state::get_bancor_input( int64_t out_reserve,
                                              int64_t inp_reserve,
                                              int64_t out )
    {
+#if EXCHANGE_STATE_FIXED_POINT
+      return bancor::get_input( out_reserve, inp_reserve, out );
+#else
       const double ob = out_reserve;
       const double ib = inp_reserve;
 
@@ -105,6 +128,7 @@ namespace eosiosystem {
       if ( inp < 0 ) inp = 0;
 
       return inp;
+#endif
    }
 
 } /// namespace eosiosystem
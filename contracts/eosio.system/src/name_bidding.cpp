@@ -1,8 +1,6 @@
 #include <eosio.system/eosio.system.hpp>
 #include <eosio.token/eosio.token.hpp>
 
-#include <eosio/transaction.hpp>
-
 namespace eosiosystem {
 
    using eosio::current_time_point;
@@ -35,30 +33,23 @@ namespace eosiosystem {
          check( bid.amount - current->high_bid > (current->high_bid / 10), "must increase bid by 10%" );
          check( current->high_bidder != bidder, "account is already highest bidder" );
 
-         bid_refund_table refunds_table(get_self(), newname.value);
-
-         auto it = refunds_table.find( current->high_bidder.value );
-         if ( it != refunds_table.end() ) {
-            refunds_table.modify( it, same_payer, [&](auto& r) {
+         // the outbid amount is added to the bid refund ledger, to be claimed with claimbidrefs
+         bid_ledger_table ledger( get_self(), get_self().value );
+         auto idx = ledger.get_index<"bybidder"_n>();
+         auto it = idx.find( (uint128_t(current->high_bidder.value) << 64) | newname.value );
+         if ( it != idx.end() ) {
+            idx.modify( it, same_payer, [&](auto& r) {
                   r.amount += asset( current->high_bid, core_symbol() );
                });
          } else {
-            refunds_table.emplace( bidder, [&](auto& r) {
-                  r.bidder = current->high_bidder;
-                  r.amount = asset( current->high_bid, core_symbol() );
+            ledger.emplace( bidder, [&](auto& r) {
+                  r.id      = ledger.available_primary_key();
+                  r.bidder  = current->high_bidder;
+                  r.newname = newname;
+                  r.amount  = asset( current->high_bid, core_symbol() );
                });
          }
 
-         eosio::transaction t;
-         t.actions.emplace_back( permission_level{current->high_bidder, active_permission},
-                                 get_self(), "bidrefund"_n,
-                                 std::make_tuple( current->high_bidder, newname )
-         );
-         t.delay_sec = 0;
-         uint128_t deferred_id = (uint128_t(newname.value) << 64) | current->high_bidder.value;
-         eosio::cancel_deferred( deferred_id );
-         t.send( deferred_id, bidder );
-
          bids.modify( current, bidder, [&]( auto& b ) {
             b.high_bidder = bidder;
             b.high_bid = bid.amount;
@@ -77,4 +68,20 @@ namespace eosiosystem {
       refunds_table.erase( it );
    }
 
+   void system_contract::claimbidrefs( const name& bidder ) {
+      require_auth( bidder );
+
+      bid_ledger_table ledger( get_self(), get_self().value );
+      auto idx = ledger.get_index<"bybidder"_n>();
+      asset total( 0, core_symbol() );
+      for ( auto it = idx.lower_bound( uint128_t(bidder.value) << 64 ); it != idx.end() && it->bidder == bidder; ) {
+         total += it->amount;
+         it = idx.erase( it );
+      }
+      check( 0 < total.amount, "no bid refunds to claim" );
+
+      token::transfer_action transfer_act{ token_account, { {names_account, active_permission}, {bidder, active_permission} } };
+      transfer_act.send( names_account, bidder, total, std::string("refund bids on names") );
+   }
+
 }
@@ -353,6 +353,37 @@ namespace eosiosystem {
       }
    }
 
+   void system_contract::quoterex( const asset& quantity )
+   {
+      /// quotes include the returns that buyrex and sellrex would add to the REX pool before the trade
+      asset quote;
+      if ( quantity.symbol == rex_symbol ) {
+         check( rex_available(), "rex system not initialized yet" );
+         check( 0 < quantity.amount && quantity.amount <= _rexpool.begin()->total_rex.amount, "invalid amount of rex to quote" );
+         quote = asset( get_rex_proceeds( quantity, get_accrued_rex_pool() ), core_symbol() );
+      } else {
+         check( quantity.symbol == core_symbol(), "asset must be core token or REX" );
+         check( 0 < quantity.amount, "must use positive amount" );
+         quote = asset( rex_available() ? get_rex_received( quantity, get_accrued_rex_pool() ) : get_rex_received( quantity ), rex_symbol );
+      }
+      // dummy action added so that the quote shows up in action trace
+      rex_results::quoteresult_action quoteresult_act( rex_account, std::vector<eosio::permission_level>{ } );
+      quoteresult_act.send( quantity, quote );
+   }
+
+   void system_contract::quoteloan( const asset& loan_payment )
+   {
+      check( rex_loans_available(), "rex loans are currently not available" );
+      check( loan_payment.symbol == core_symbol(), "must use core token" );
+      check( 0 < loan_payment.amount, "must use positive asset amount" );
+
+      /// quotes include the returns that rentcpu and rentnet would add to the REX pool before renting
+      const asset quote( get_rented_tokens( loan_payment, get_accrued_rex_pool() ), core_symbol() );
+      // dummy action added so that the quote shows up in action trace
+      rex_results::quoteresult_action quoteresult_act( rex_account, std::vector<eosio::permission_level>{ } );
+      quoteresult_act.send( loan_payment, quote );
+   }
+
    /**
     * @brief Updates account NET and CPU resource limits
     *
@@ -397,9 +428,9 @@ namespace eosiosystem {
 
          if( !(net_managed && cpu_managed) ) {
             int64_t ram_bytes = 0, net = 0, cpu = 0;
-            get_resource_limits( receiver, ram_bytes, net, cpu );
+            get_account_limits( receiver, ram_bytes, net, cpu );
 
-            set_resource_limits( receiver,
+            set_account_limits( receiver,
                                  ram_bytes,
                                  net_managed ? net : tot_itr->net_weight.amount,
                                  cpu_managed ? cpu : tot_itr->cpu_weight.amount );
@@ -619,6 +650,8 @@ namespace eosiosystem {
 
    /**
     * @brief Adds returns from the REX return pool to the REX pool
+    *
+    * get_accrued_rex_pool computes the same returns without updating any table and must be kept in line with it.
     */
    void system_contract::update_rex_pool()
    {
@@ -630,13 +663,26 @@ namespace eosiosystem {
       const uint32_t       cts            = ct.sec_since_epoch();
       const time_point_sec effective_time{cts - cts % rex_return_pool::dist_interval};
 
-      const auto ret_pool_elem    = _rexretpool.begin();
-      const auto ret_buckets_elem = _rexretbuckets.begin();
+      /// last_dist_time is a multiple of dist_interval, so nothing can be distributed before next_rex_dist_time
+      if ( _gstate3.next_rex_dist_time.has_value() && ct < *_gstate3.next_rex_dist_time ) {
+         return;
+      }
+
+      const auto ret_pool_elem = _rexretpool.begin();
 
-      if ( ret_pool_elem == _rexretpool.end() || effective_time <= ret_pool_elem->last_dist_time ) {
+      if ( ret_pool_elem == _rexretpool.end() ) {
+         _gstate3.next_rex_dist_time.emplace( time_point_sec::maximum() ); /// reset by add_to_rex_return_pool
          return;
       }
 
+      _gstate3.next_rex_dist_time.emplace( std::max( effective_time, ret_pool_elem->last_dist_time ) + seconds(rex_return_pool::dist_interval) );
+
+      if ( effective_time <= ret_pool_elem->last_dist_time ) {
+         return;
+      }
+
+      /// all elapsed intervals are accounted for in closed form below, return buckets are only read when one
+      /// of them is created or expires
       const int64_t  current_rate      = ret_pool_elem->current_rate_of_increase;
       const uint32_t elapsed_intervals = get_elapsed_intervals( effective_time, ret_pool_elem->last_dist_time );
       int64_t        change_estimate   = current_rate * elapsed_intervals;
@@ -663,7 +709,7 @@ namespace eosiosystem {
          });
 
          if ( new_return_bucket ) {
-            _rexretbuckets.modify( ret_buckets_elem, same_payer, [&]( auto& rb ) {
+            _rexretbuckets.modify( _rexretbuckets.begin(), same_payer, [&]( auto& rb ) {
                rb.return_buckets[new_bucket_time] = new_bucket_rate;
             });
          }
@@ -671,6 +717,7 @@ namespace eosiosystem {
 
       const time_point_sec time_threshold = effective_time - seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval);
       if ( ret_pool_elem->oldest_bucket_time <= time_threshold ) {
+         const auto ret_buckets_elem = _rexretbuckets.begin();
          int64_t expired_rate = 0;
          int64_t surplus      = 0;
          _rexretbuckets.modify( ret_buckets_elem, same_payer, [&]( auto& rb ) {
@@ -719,6 +766,75 @@ namespace eosiosystem {
       }
    }
 
+   /**
+    * @brief Returns the REX pool with the returns that update_rex_pool would add to it now, without updating
+    * the REX pool, the REX return pool or the return buckets
+    *
+    * @return rex_pool - copy of the REX pool, which must be initialized
+    */
+   rex_pool system_contract::get_accrued_rex_pool()const
+   {
+      auto get_elapsed_intervals = [&]( const time_point_sec& t1, const time_point_sec& t0 ) -> uint32_t {
+         return ( t1.sec_since_epoch() - t0.sec_since_epoch() ) / rex_return_pool::dist_interval;
+      };
+
+      rex_pool pool = *_rexpool.begin();
+
+      const time_point_sec ct             = current_time_point();
+      const uint32_t       cts            = ct.sec_since_epoch();
+      const time_point_sec effective_time{cts - cts % rex_return_pool::dist_interval};
+
+      const auto ret_pool_elem = _rexretpool.begin();
+      if ( ( _gstate3.next_rex_dist_time.has_value() && ct < *_gstate3.next_rex_dist_time )
+           || ret_pool_elem == _rexretpool.end() || effective_time <= ret_pool_elem->last_dist_time ) {
+         return pool;
+      }
+
+      int64_t change_estimate = ret_pool_elem->current_rate_of_increase * get_elapsed_intervals( effective_time, ret_pool_elem->last_dist_time );
+      int64_t proceeds        = ret_pool_elem->proceeds;
+
+      /// the pending bucket becomes a return bucket once its time has passed
+      const bool new_return_bucket = ret_pool_elem->pending_bucket_time <= effective_time;
+      int64_t    new_bucket_rate   = 0;
+      if ( new_return_bucket ) {
+         const int64_t remainder = ret_pool_elem->pending_bucket_proceeds % rex_return_pool::total_intervals;
+         new_bucket_rate  = ( ret_pool_elem->pending_bucket_proceeds - remainder ) / rex_return_pool::total_intervals;
+         change_estimate += remainder + new_bucket_rate * get_elapsed_intervals( effective_time, ret_pool_elem->pending_bucket_time );
+      }
+      proceeds -= change_estimate;
+
+      /// returns of expired buckets accrued beyond their expiration are given back to the return pool
+      const time_point_sec time_threshold = effective_time - seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval);
+      int64_t surplus = 0;
+      auto add_surplus = [&]( const time_point_sec& bucket_time, int64_t rate ) {
+         surplus += rate * get_elapsed_intervals( effective_time,
+                                                  bucket_time + seconds(rex_return_pool::total_intervals * rex_return_pool::dist_interval) );
+      };
+      if ( ret_pool_elem->oldest_bucket_time <= time_threshold ) {
+         const auto& return_buckets = _rexretbuckets.begin()->return_buckets;
+         for ( auto iter = return_buckets.begin(); iter != return_buckets.end() && iter->first <= time_threshold; ++iter ) {
+            add_surplus( iter->first, iter->second );
+         }
+      }
+      if ( new_return_bucket && ret_pool_elem->pending_bucket_time <= time_threshold ) {
+         add_surplus( ret_pool_elem->pending_bucket_time, new_bucket_rate );
+      }
+      if ( surplus > 0 ) {
+         change_estimate -= surplus;
+         proceeds        += surplus;
+      }
+
+      if ( change_estimate > 0 && proceeds < 0 ) {
+         change_estimate += proceeds;
+      }
+
+      if ( change_estimate > 0 ) {
+         pool.total_unlent.amount += change_estimate;
+         pool.total_lendable       = pool.total_unlent + pool.total_lent;
+      }
+      return pool;
+   }
+
    template <typename T>
    int64_t system_contract::rent_rex( T& table, const name& from, const name& receiver, const asset& payment, const asset& fund )
    {
@@ -732,9 +848,7 @@ namespace eosiosystem {
 
       const auto& pool = _rexpool.begin(); /// already checked that _rexpool.begin() != _rexpool.end() in rex_loans_available()
 
-      int64_t rented_tokens = exchange_state::get_bancor_output( pool->total_rent.amount,
-                                                                 pool->total_unlent.amount,
-                                                                 payment.amount );
+      int64_t rented_tokens = get_rented_tokens( payment );
       check( payment.amount < rented_tokens, "loan price does not favor renting" );
       add_loan_to_rex_pool( payment, rented_tokens, true );
 
@@ -774,7 +888,7 @@ namespace eosiosystem {
       auto rexitr = _rexpool.begin();
       const int64_t S0 = rexitr->total_lendable.amount;
       const int64_t R0 = rexitr->total_rex.amount;
-      const int64_t p  = (uint128_t(rex.amount) * S0) / R0;
+      const int64_t p  = get_rex_proceeds( rex );
       const int64_t R1 = R0 - rex.amount;
       const int64_t S1 = S0 - p;
       asset proceeds( p, core_symbol() );
@@ -1010,22 +1124,12 @@ namespace eosiosystem {
     */
    asset system_contract::add_to_rex_pool( const asset& payment )
    {
-      /**
-       * If CORE_SYMBOL is (EOS,4), maximum supply is 10^10 tokens (10 billion tokens), i.e., maximum amount
-       * of indivisible units is 10^14. rex_ratio = 10^4 sets the upper bound on (REX,4) indivisible units to
-       * 10^18 and that is within the maximum allowable amount field of asset type which is set to 2^62
-       * (approximately 4.6 * 10^18). For a different CORE_SYMBOL, and in order for maximum (REX,4) amount not
-       * to exceed that limit, maximum amount of indivisible units cannot be set to a value larger than 4 * 10^14.
-       * If precision of CORE_SYMBOL is 4, that corresponds to a maximum supply of 40 billion tokens.
-       */
-      const int64_t rex_ratio = 10000;
       const asset   init_total_rent( 20'000'0000, core_symbol() ); /// base balance prevents renting profitably until at least a minimum number of core_symbol() is made available
-      asset rex_received( 0, rex_symbol );
+      const asset   rex_received( get_rex_received( payment ), rex_symbol );
       auto itr = _rexpool.begin();
       if ( !rex_system_initialized() ) {
          /// initialize REX pool
          _rexpool.emplace( get_self(), [&]( auto& rp ) {
-            rex_received.amount = payment.amount * rex_ratio;
             rp.total_lendable   = payment;
             rp.total_lent       = asset( 0, core_symbol() );
             rp.total_unlent     = rp.total_lendable - rp.total_lent;
@@ -1035,7 +1139,6 @@ namespace eosiosystem {
          });
       } else if ( !rex_available() ) { /// should be a rare corner case, REX pool is initialized but empty
          _rexpool.modify( itr, same_payer, [&]( auto& rp ) {
-            rex_received.amount      = payment.amount * rex_ratio;
             rp.total_lendable.amount = payment.amount;
             rp.total_lent.amount     = 0;
             rp.total_unlent.amount   = rp.total_lendable.amount - rp.total_lent.amount;
@@ -1043,16 +1146,9 @@ namespace eosiosystem {
             rp.total_rex.amount      = rex_received.amount;
          });
       } else {
-         /// total_lendable > 0 if total_rex > 0 except in a rare case and due to rounding errors
-         check( itr->total_lendable.amount > 0, "lendable REX pool is empty" );
-         const int64_t S0 = itr->total_lendable.amount;
-         const int64_t S1 = S0 + payment.amount;
-         const int64_t R0 = itr->total_rex.amount;
-         const int64_t R1 = (uint128_t(S1) * R0) / S0;
-         rex_received.amount = R1 - R0;
          _rexpool.modify( itr, same_payer, [&]( auto& rp ) {
-            rp.total_lendable.amount = S1;
-            rp.total_rex.amount      = R1;
+            rp.total_lendable.amount += payment.amount;
+            rp.total_rex.amount      += rex_received.amount;
             rp.total_unlent.amount   = rp.total_lendable.amount - rp.total_lent.amount;
             check( rp.total_unlent.amount >= 0, "programmer error, this should never go negative" );
          });
@@ -1061,6 +1157,76 @@ namespace eosiosystem {
       return rex_received;
    }
 
+   /**
+    * @brief Calculates amount of REX tokens received for a payment without updating the REX pool
+    *
+    * @param payment - amount of core tokens paid
+    *
+    * @return int64_t - amount of REX tokens add_to_rex_pool would issue for payment
+    */
+   int64_t system_contract::get_rex_received( const asset& payment )const
+   {
+      /**
+       * If CORE_SYMBOL is (EOS,4), maximum supply is 10^10 tokens (10 billion tokens), i.e., maximum amount
+       * of indivisible units is 10^14. rex_ratio = 10^4 sets the upper bound on (REX,4) indivisible units to
+       * 10^18 and that is within the maximum allowable amount field of asset type which is set to 2^62
+       * (approximately 4.6 * 10^18). For a different CORE_SYMBOL, and in order for maximum (REX,4) amount not
+       * to exceed that limit, maximum amount of indivisible units cannot be set to a value larger than 4 * 10^14.
+       * If precision of CORE_SYMBOL is 4, that corresponds to a maximum supply of 40 billion tokens.
+       */
+      const int64_t rex_ratio = 10000;
+      if ( !rex_available() ) {
+         return payment.amount * rex_ratio;
+      }
+
+      return get_rex_received( payment, *_rexpool.begin() );
+   }
+
+   int64_t system_contract::get_rex_received( const asset& payment, const rex_pool& pool )const
+   {
+      /// total_lendable > 0 if total_rex > 0 except in a rare case and due to rounding errors
+      check( pool.total_lendable.amount > 0, "lendable REX pool is empty" );
+      const int64_t S0 = pool.total_lendable.amount;
+      const int64_t S1 = S0 + payment.amount;
+      const int64_t R0 = pool.total_rex.amount;
+      const int64_t R1 = (uint128_t(S1) * R0) / S0;
+      return R1 - R0;
+   }
+
+   /**
+    * @brief Calculates core tokens received for selling REX without updating the REX pool
+    *
+    * @param rex - amount of REX tokens sold
+    *
+    * @return int64_t - proceeds of a filled sellrex order
+    */
+   int64_t system_contract::get_rex_proceeds( const asset& rex )const
+   {
+      return get_rex_proceeds( rex, *_rexpool.begin() );
+   }
+
+   int64_t system_contract::get_rex_proceeds( const asset& rex, const rex_pool& pool )const
+   {
+      return (uint128_t(rex.amount) * pool.total_lendable.amount) / pool.total_rex.amount;
+   }
+
+   /**
+    * @brief Calculates core tokens staked to a new loan without updating the REX pool
+    *
+    * @param payment - loan fee paid
+    *
+    * @return int64_t - amount of tokens staked to loan receiver
+    */
+   int64_t system_contract::get_rented_tokens( const asset& payment )const
+   {
+      return get_rented_tokens( payment, *_rexpool.begin() );
+   }
+
+   int64_t system_contract::get_rented_tokens( const asset& payment, const rex_pool& pool )const
+   {
+      return exchange_state::get_bancor_output( pool.total_rent.amount, pool.total_unlent.amount, payment.amount );
+   }
+
    /**
     * @brief Adds an amount of core tokens to the REX return pool
     *
@@ -1086,6 +1252,7 @@ namespace eosiosystem {
             rp.proceeds                = fee.amount;
          });
          _rexretbuckets.emplace( get_self(), [&]( auto& rb ) { } );
+         _gstate3.next_rex_dist_time.emplace( effective_time + seconds(rex_return_pool::dist_interval) );
       } else {
          _rexretpool.modify( return_pool_elem, same_payer, [&]( auto& rp ) {
             rp.pending_bucket_proceeds += fee.amount;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
 #include <eosio/eosio.hpp>
 
 #include <string>
@@ -13,6 +14,17 @@ namespace eosio {
 
    using std::string;
 
+   /**
+    * A single entry of a `transfers` or `issuemany` batch: `quantity` tokens sent to `to` with `memo`.
+    */
+   struct transfer_entry {
+      name     to;
+      asset    quantity;
+      string   memo;
+
+      EOSLIB_SERIALIZE( transfer_entry, (to)(quantity)(memo) )
+   };
+
    /**
     * eosio.token contract defines the structures and actions that allow users to create, issue, and manage
     * tokens on EOSIO based blockchains.
@@ -45,6 +57,18 @@ namespace eosio {
          [[eosio::action]]
          void issue( const name& to, const asset& quantity, const string& memo );
 
+         /**
+          * This action issues tokens of a single symbol directly to many accounts.
+          * The supply is increased once by the sum of all quantities and each `to` account is credited with its quantity.
+          *
+          * @param issues - the accounts to issue tokens to, each with the quantity and memo of its issue.
+          *
+          * @pre All quantities must be positive and of the same symbol,
+          * @pre The sum of all quantities must not exceed the available supply.
+          */
+         [[eosio::action]]
+         void issuemany( const std::vector<transfer_entry>& issues );
+
          /**
           * The opposite for create action, if all validations succeed,
           * it debits the statstable.supply amount.
@@ -69,6 +93,20 @@ namespace eosio {
                         const name&    to,
                         const asset&   quantity,
                         const string&  memo );
+
+         /**
+          * Allows `from` account to transfer tokens of a single symbol to many accounts.
+          * `from` is debited once with the sum of all quantities and each `to` account is credited with its quantity.
+          *
+          * @param from - the account to transfer from,
+          * @param transfers - the accounts to be transferred to, each with the quantity and memo of its transfer.
+          *
+          * @pre All quantities must be positive and of the same symbol,
+          * @pre `from` cannot be one of the accounts transferred to.
+          */
+         [[eosio::action]]
+         void transfers( const name& from, const std::vector<transfer_entry>& transfers );
+
          /**
           * Allows `ram_payer` to create an account `owner` with zero balance for
           * token `symbol` at the expense of `ram_payer`.
@@ -96,6 +134,55 @@ namespace eosio {
          [[eosio::action]]
          void close( const name& owner, const symbol& symbol );
 
+         /**
+          * Switches the balances of token `sym` to the compact format: a fixed-width row holding only the amount
+          * and the precision, in the `balances` table. Balances in the `accounts` table are moved to the compact
+          * format the next time their owner is debited.
+          *
+          * @param sym - the symbol code of the token.
+          *
+          * @pre The token must exist and its balances must not be compact already.
+          */
+         [[eosio::action]]
+         void setcompact( const symbol_code& sym );
+
+         /**
+          * Reports the supply of token `sym` through the inline `supplyres` action. No state is changed.
+          *
+          * @param sym - the symbol code of the token.
+          */
+         [[eosio::action]]
+         void getsupply( const symbol_code& sym );
+
+         /**
+          * Reports the balance of `owner` for token `sym` through the inline `balanceres` action. No state is changed.
+          *
+          * @param owner - the account whose balance is reported,
+          * @param sym - the symbol code of the token.
+          */
+         [[eosio::action]]
+         void getbalance( const name& owner, const symbol_code& sym );
+
+         /**
+          * The actions `supplyres` and `balanceres` are no-ops, added as inline convenience actions to `getsupply`
+          * and `getbalance`. Their data includes the result of the parent action and appears in its trace.
+          *
+          * @param supply - the current supply of the token,
+          * @param max_supply - the maximum supply of the token,
+          * @param issuer - the issuer of the token.
+          */
+         [[eosio::action]]
+         void supplyres( const asset& supply, const asset& max_supply, const name& issuer ) {}
+
+         /**
+          * See `supplyres`.
+          *
+          * @param owner - the account whose balance was queried,
+          * @param balance - the balance of `owner`.
+          */
+         [[eosio::action]]
+         void balanceres( const name& owner, const asset& balance ) {}
+
          static asset get_supply( const name& token_contract_account, const symbol_code& sym_code )
          {
             stats statstable( token_contract_account, sym_code.raw() );
@@ -105,6 +192,10 @@ namespace eosio {
 
          static asset get_balance( const name& token_contract_account, const name& owner, const symbol_code& sym_code )
          {
+            asset balance;
+            if ( find_compact_balance( token_contract_account, owner, sym_code, balance ) >= 0 ) {
+               return balance;
+            }
             accounts accountstable( token_contract_account, owner.value );
             const auto& ac = accountstable.get( sym_code.raw() );
             return ac.balance;
@@ -112,10 +203,17 @@ namespace eosio {
 
          using create_action = eosio::action_wrapper<"create"_n, &token::create>;
          using issue_action = eosio::action_wrapper<"issue"_n, &token::issue>;
+         using issuemany_action = eosio::action_wrapper<"issuemany"_n, &token::issuemany>;
          using retire_action = eosio::action_wrapper<"retire"_n, &token::retire>;
          using transfer_action = eosio::action_wrapper<"transfer"_n, &token::transfer>;
+         using transfers_action = eosio::action_wrapper<"transfers"_n, &token::transfers>;
          using open_action = eosio::action_wrapper<"open"_n, &token::open>;
          using close_action = eosio::action_wrapper<"close"_n, &token::close>;
+         using setcompact_action = eosio::action_wrapper<"setcompact"_n, &token::setcompact>;
+         using getsupply_action = eosio::action_wrapper<"getsupply"_n, &token::getsupply>;
+         using getbalance_action = eosio::action_wrapper<"getbalance"_n, &token::getbalance>;
+         using supplyres_action = eosio::action_wrapper<"supplyres"_n, &token::supplyres>;
+         using balanceres_action = eosio::action_wrapper<"balanceres"_n, &token::balanceres>;
       private:
          struct [[eosio::table]] account {
             asset    balance;
@@ -127,15 +225,53 @@ namespace eosio {
             asset    supply;
             asset    max_supply;
             name     issuer;
+            binary_extension<bool> compact_balances;
 
             uint64_t primary_key()const { return supply.symbol.code().raw(); }
+            bool     compact()const     { return compact_balances.value_or( false ); }
+
+            EOSLIB_SERIALIZE( currency_stats, (supply)(max_supply)(issuer)(compact_balances) )
+         };
+
+         // Compact balance row of the `balances` table, scoped by owner. The primary key is the symbol code,
+         // which is not repeated in the row; rows are accessed with the database intrinsics directly since
+         // multi_index requires the key to be part of the row.
+         struct [[eosio::table("balances")]] compact_balance {
+            int64_t  amount;
+            uint8_t  precision;
+
+            EOSLIB_SERIALIZE( compact_balance, (amount)(precision) )
          };
 
+         static constexpr name     compact_balances_table{"balances"_n};
+         static constexpr uint32_t compact_balance_size = sizeof(int64_t) + sizeof(uint8_t);
+
          typedef eosio::multi_index< "accounts"_n, account > accounts;
          typedef eosio::multi_index< "stat"_n, currency_stats > stats;
 
-         void sub_balance( const name& owner, const asset& value );
-         void add_balance( const name& owner, const asset& value, const name& ram_payer );
+         /**
+          * Returns the database iterator of the compact balance of `owner` for `sym_code`, negative if there is none,
+          * and reads the balance into `balance` if there is one.
+          */
+         static int32_t find_compact_balance( const name& token_contract_account, const name& owner, const symbol_code& sym_code, asset& balance )
+         {
+            const int32_t itr = internal_use_do_not_use::db_find_i64( token_contract_account.value, owner.value,
+                                                                      compact_balances_table.value, sym_code.raw() );
+            if ( itr >= 0 ) {
+               char buffer[compact_balance_size];
+               internal_use_do_not_use::db_get_i64( itr, buffer, compact_balance_size );
+               datastream<const char*> ds( buffer, compact_balance_size );
+               compact_balance row;
+               ds >> row;
+               balance = asset( row.amount, symbol( sym_code, row.precision ) );
+            }
+            return itr;
+         }
+
+         void store_compact_balance( int32_t itr, const name& owner, const asset& value, const name& ram_payer );
+
+         void sub_balance( const name& owner, const asset& value, bool compact );
+         void add_balance( const name& owner, const asset& value, const name& ram_payer, bool compact );
    };
 
 }
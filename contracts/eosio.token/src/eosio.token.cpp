@@ -47,7 +47,42 @@ void token::issue( const name& to, const asset& quantity, const string& memo )
        s.supply += quantity;
     });
 
-    add_balance( st.issuer, quantity, st.issuer );
+    add_balance( st.issuer, quantity, st.issuer, st.compact() );
+}
+
+void token::issuemany( const std::vector<transfer_entry>& issues )
+{
+    check( !issues.empty(), "no issues provided" );
+    auto sym = issues.front().quantity.symbol;
+    check( sym.is_valid(), "invalid symbol name" );
+
+    stats statstable( get_self(), sym.code().raw() );
+    auto existing = statstable.find( sym.code().raw() );
+    check( existing != statstable.end(), "token with symbol does not exist, create token before issue" );
+    const auto& st = *existing;
+
+    require_auth( st.issuer );
+
+    asset total( 0, st.supply.symbol );
+    for( const auto& i : issues ) {
+       check( is_account( i.to ), "to account does not exist" );
+       check( i.quantity.is_valid(), "invalid quantity" );
+       check( i.quantity.amount > 0, "must issue positive quantity" );
+       check( i.quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+       check( i.memo.size() <= 256, "memo has more than 256 bytes" );
+
+       require_recipient( i.to );
+       total += i.quantity;
+    }
+    check( total.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
+
+    statstable.modify( st, same_payer, [&]( auto& s ) {
+       s.supply += total;
+    });
+
+    for( const auto& i : issues ) {
+       add_balance( i.to, i.quantity, has_auth( i.to ) ? i.to : st.issuer, st.compact() );
+    }
 }
 
 void token::retire( const asset& quantity, const string& memo )
@@ -71,7 +106,7 @@ void token::retire( const asset& quantity, const string& memo )
        s.supply -= quantity;
     });
 
-    sub_balance( st.issuer, quantity );
+    sub_balance( st.issuer, quantity, st.compact() );
 }
 
 void token::transfer( const name&    from,
@@ -96,11 +131,58 @@ void token::transfer( const name&    from,
 
     auto payer = has_auth( to ) ? to : from;
 
-    sub_balance( from, quantity );
-    add_balance( to, quantity, payer );
+    sub_balance( from, quantity, st.compact() );
+    add_balance( to, quantity, payer, st.compact() );
+}
+
+void token::transfers( const name& from, const std::vector<transfer_entry>& transfers )
+{
+    require_auth( from );
+    check( !transfers.empty(), "no transfers provided" );
+    auto sym = transfers.front().quantity.symbol;
+    stats statstable( get_self(), sym.code().raw() );
+    const auto& st = statstable.get( sym.code().raw() );
+
+    require_recipient( from );
+
+    asset total( 0, st.supply.symbol );
+    for( const auto& t : transfers ) {
+       check( from != t.to, "cannot transfer to self" );
+       check( is_account( t.to ), "to account does not exist");
+       check( t.quantity.is_valid(), "invalid quantity" );
+       check( t.quantity.amount > 0, "must transfer positive quantity" );
+       check( t.quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+       check( t.memo.size() <= 256, "memo has more than 256 bytes" );
+
+       require_recipient( t.to );
+       total += t.quantity;
+    }
+
+    sub_balance( from, total, st.compact() );
+    for( const auto& t : transfers ) {
+       add_balance( t.to, t.quantity, has_auth( t.to ) ? t.to : from, st.compact() );
+    }
 }
 
-void token::sub_balance( const name& owner, const asset& value ) {
+void token::sub_balance( const name& owner, const asset& value, bool compact ) {
+   if ( compact ) {
+      asset balance;
+      const int32_t itr = find_compact_balance( get_self(), owner, value.symbol.code(), balance );
+      if ( itr >= 0 ) {
+         check( balance.amount >= value.amount, "overdrawn balance" );
+         store_compact_balance( itr, owner, balance - value, owner );
+         return;
+      }
+
+      // the balance is moved from the accounts table to the compact format
+      accounts from_acnts( get_self(), owner.value );
+      const auto& from = from_acnts.get( value.symbol.code().raw(), "no balance object found" );
+      check( from.balance.amount >= value.amount, "overdrawn balance" );
+      store_compact_balance( itr, owner, from.balance - value, owner );
+      from_acnts.erase( from );
+      return;
+   }
+
    accounts from_acnts( get_self(), owner.value );
 
    const auto& from = from_acnts.get( value.symbol.code().raw(), "no balance object found" );
@@ -111,21 +193,50 @@ void token::sub_balance( const name& owner, const asset& value ) {
       });
 }
 
-void token::add_balance( const name& owner, const asset& value, const name& ram_payer )
+void token::add_balance( const name& owner, const asset& value, const name& ram_payer, bool compact )
 {
+   int32_t compact_itr = -1;
+   if ( compact ) {
+      asset balance;
+      compact_itr = find_compact_balance( get_self(), owner, value.symbol.code(), balance );
+      if ( compact_itr >= 0 ) {
+         store_compact_balance( compact_itr, owner, balance + value, same_payer );
+         return;
+      }
+   }
+
    accounts to_acnts( get_self(), owner.value );
    auto to = to_acnts.find( value.symbol.code().raw() );
    if( to == to_acnts.end() ) {
+      if ( compact ) {
+         store_compact_balance( compact_itr, owner, value, ram_payer );
+         return;
+      }
       to_acnts.emplace( ram_payer, [&]( auto& a ){
         a.balance = value;
       });
    } else {
+      // a balance not yet in the compact format is moved the next time its owner is debited
       to_acnts.modify( to, same_payer, [&]( auto& a ) {
         a.balance += value;
       });
    }
 }
 
+void token::store_compact_balance( int32_t itr, const name& owner, const asset& value, const name& ram_payer )
+{
+   char buffer[compact_balance_size];
+   datastream<char*> ds( buffer, compact_balance_size );
+   ds << compact_balance{ value.amount, value.symbol.precision() };
+
+   if ( itr >= 0 ) {
+      internal_use_do_not_use::db_update_i64( itr, ram_payer.value, buffer, compact_balance_size );
+   } else {
+      internal_use_do_not_use::db_store_i64( owner.value, compact_balances_table.value, ram_payer.value,
+                                             value.symbol.code().raw(), buffer, compact_balance_size );
+   }
+}
+
 void token::open( const name& owner, const symbol& symbol, const name& ram_payer )
 {
    require_auth( ram_payer );
@@ -140,6 +251,14 @@ void token::open( const name& owner, const symbol& symbol, const name& ram_payer
    accounts acnts( get_self(), owner.value );
    auto it = acnts.find( sym_code_raw );
    if( it == acnts.end() ) {
+      if( st.compact() ) {
+         asset balance;
+         const int32_t itr = find_compact_balance( get_self(), owner, symbol.code(), balance );
+         if( itr < 0 ) {
+            store_compact_balance( itr, owner, asset{0, symbol}, ram_payer );
+         }
+         return;
+      }
       acnts.emplace( ram_payer, [&]( auto& a ){
         a.balance = asset{0, symbol};
       });
@@ -149,6 +268,15 @@ void token::open( const name& owner, const symbol& symbol, const name& ram_payer
 void token::close( const name& owner, const symbol& symbol )
 {
    require_auth( owner );
+
+   asset balance;
+   const int32_t itr = find_compact_balance( get_self(), owner, symbol.code(), balance );
+   if ( itr >= 0 ) {
+      check( balance.amount == 0, "Cannot close because the balance is not zero." );
+      internal_use_do_not_use::db_remove_i64( itr );
+      return;
+   }
+
    accounts acnts( get_self(), owner.value );
    auto it = acnts.find( symbol.code().raw() );
    check( it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect." );
@@ -156,4 +284,36 @@ void token::close( const name& owner, const symbol& symbol )
    acnts.erase( it );
 }
 
+void token::setcompact( const symbol_code& sym )
+{
+   require_auth( get_self() );
+
+   stats statstable( get_self(), sym.raw() );
+   const auto& st = statstable.get( sym.raw(), "symbol does not exist" );
+   check( !st.compact(), "balances are already compact" );
+
+   statstable.modify( st, same_payer, [&]( auto& s ) {
+      s.compact_balances.emplace( true );
+   });
+}
+
+void token::getsupply( const symbol_code& sym )
+{
+   stats statstable( get_self(), sym.raw() );
+   const auto& st = statstable.get( sym.raw(), "symbol does not exist" );
+   supplyres_action supplyres_act{ get_self(), std::vector<permission_level>{} };
+   supplyres_act.send( st.supply, st.max_supply, st.issuer );
+}
+
+void token::getbalance( const name& owner, const symbol_code& sym )
+{
+   asset balance;
+   if ( find_compact_balance( get_self(), owner, sym, balance ) < 0 ) {
+      accounts acnts( get_self(), owner.value );
+      balance = acnts.get( sym.raw(), "no balance object found" ).balance;
+   }
+   balanceres_action balanceres_act{ get_self(), std::vector<permission_level>{} };
+   balanceres_act.send( owner, balance );
+}
+
 } /// namespace eosio
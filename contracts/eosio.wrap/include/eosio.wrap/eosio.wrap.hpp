@@ -2,6 +2,7 @@
 
 #include <eosio/eosio.hpp>
 #include <eosio/ignore.hpp>
+#include <eosio/singleton.hpp>
 #include <eosio/transaction.hpp>
 
 namespace eosio {
@@ -36,7 +37,37 @@ namespace eosio {
          [[eosio::action]]
          void exec( ignore<name> executer, ignore<transaction> trx );
 
+         /**
+          * Execute many action.
+          *
+          * Execute several transactions while bypassing regular authorization checks.
+          * The actions of transactions without delay and without context free actions are sent as inline
+          * actions, in order, and fail together with this action. Other transactions are sent as deferred
+          * transactions, like `exec` does.
+          *
+          * @param executer - account executing the transactions,
+          * @param trxs - the transactions to be executed.
+          *
+          * @pre Requires authorization of eosio.wrap which needs to be a privileged account.
+          *
+          * @post Deferred transaction RAM usage is billed to 'executer'
+          */
+         [[eosio::action]]
+         void execmany( ignore<name> executer, ignore<std::vector<transaction>> trxs );
+
          using exec_action = eosio::action_wrapper<"exec"_n, &wrap::exec>;
+         using execmany_action = eosio::action_wrapper<"execmany"_n, &wrap::execmany>;
+
+      private:
+         //sender ids of deferred transactions are taken from a counter, so that wrapped transactions
+         //sent at the same time do not replace each other
+         struct [[eosio::table]] wrap_state {
+            uint64_t next_sender_id = 0;
+         };
+
+         typedef eosio::singleton< "state"_n, wrap_state > wrap_state_singleton;
+
+         static uint128_t sender_id( name executer, uint64_t id ) { return (uint128_t(executer.value) << 64) | id; }
    };
    /** @}*/ // end of @defgroup eosiowrap eosio.wrap
 } /// namespace eosio
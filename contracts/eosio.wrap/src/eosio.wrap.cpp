@@ -10,7 +10,41 @@ void wrap::exec( ignore<name>, ignore<transaction> ) {
 
    require_auth( executer );
 
-   send_deferred( (uint128_t(executer.value) << 64) | (uint64_t)current_time_point().time_since_epoch().count(), executer, _ds.pos(), _ds.remaining() );
+   wrap_state_singleton state_table( get_self(), get_self().value );
+   auto state = state_table.get_or_default();
+   send_deferred( sender_id( executer, state.next_sender_id++ ), executer, _ds.pos(), _ds.remaining() );
+   state_table.set( state, get_self() );
+}
+
+void wrap::execmany( ignore<name>, ignore<std::vector<transaction>> ) {
+   require_auth( get_self() );
+
+   name executer;
+   unsigned_int count;
+   _ds >> executer >> count;
+
+   require_auth( executer );
+   check( count.value > 0, "no transactions provided" );
+
+   wrap_state_singleton state_table( get_self(), get_self().value );
+   auto state = state_table.get_or_default();
+   const uint64_t first_sender_id = state.next_sender_id;
+   for ( uint32_t i = 0; i < count.value; ++i ) {
+      const char* trx_pos = _ds.pos();
+      transaction trx;
+      _ds >> trx;
+      if ( trx.delay_sec.value == 0 && trx.context_free_actions.empty() ) {
+         //eosio.wrap is privileged, so its inline actions are not subject to authorization checks
+         for ( const auto& act : trx.actions ) {
+            act.send();
+         }
+      } else {
+         send_deferred( sender_id( executer, state.next_sender_id++ ), executer, trx_pos, _ds.pos() - trx_pos );
+      }
+   }
+   if ( state.next_sender_id != first_sender_id ) {
+      state_table.set( state, get_self() );
+   }
 }
 
 } /// namespace eosio
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <eosio/action.hpp>
+#include <eosio/binary_extension.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/fixed_bytes.hpp>
 #include <eosio/privileged.hpp>
 #include <eosio/producer_schedule.hpp>
+#include <eosio/time.hpp>
 
 /**
  * LACCHAIN EOSIO System Contract
@@ -167,8 +169,9 @@ namespace lacchainsystem {
 
          /**
           * Set abi action sets the abi for contract identified by `account` name. Creates an entry in the abi_hash_table
-          * index, with `account` name as key, if it is not already present and sets its value with the abi hash.
-          * Otherwise it is updating the current abi hash value for the existing `account` key.
+          * index, with `account` name as key, if it is not already present and sets its value with the abi hash,
+          * the abi size and the time of the current block. Otherwise it is updating these values for the existing
+          * `account` key, unless the abi hash is unchanged.
           *
           * @param account - the name of the account to set the abi for
           * @param abi     - the abi hash represented as a vector of characters
@@ -384,9 +387,12 @@ namespace lacchainsystem {
          struct [[eosio::table]] abi_hash {
             name              owner;
             checksum256       hash;
+            // size of the abi and time of the block that last changed it, missing in entries recorded before they were stored
+            eosio::binary_extension<uint32_t>                size;
+            eosio::binary_extension<eosio::block_timestamp>  last_update;
             uint64_t primary_key()const { return owner.value; }
 
-            EOSLIB_SERIALIZE( abi_hash, (owner)(hash) )
+            EOSLIB_SERIALIZE( abi_hash, (owner)(hash)(size)(last_update) )
          };
 
          typedef eosio::multi_index< "abihash"_n, abi_hash > abi_hash_table;
@@ -5,15 +5,21 @@ namespace lacchainsystem {
 
 void lacchain::setabi( name account, const std::vector<char>& abi ) {
    abi_hash_table table(get_self(), get_self().value);
+   const auto hash = eosio::sha256(const_cast<char*>(abi.data()), abi.size());
    auto itr = table.find( account.value );
    if( itr == table.end() ) {
       table.emplace( account, [&]( auto& row ) {
-         row.owner = account;
-         row.hash  = eosio::sha256(const_cast<char*>(abi.data()), abi.size());
+         row.owner       = account;
+         row.hash        = hash;
+         row.size        = abi.size();
+         row.last_update = eosio::current_block_time();
       });
-   } else {
+   } else if( itr->hash != hash || !itr->size ) {
+      // setting an identical abi again does not rewrite the entry
       table.modify( itr, eosio::same_payer, [&]( auto& row ) {
-         row.hash = eosio::sha256(const_cast<char*>(abi.data()), abi.size());
+         row.hash        = hash;
+         row.size        = abi.size();
+         row.last_update = eosio::current_block_time();
       });
    }
 }
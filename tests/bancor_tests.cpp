@@ -0,0 +1,161 @@
+#include <boost/test/unit_test.hpp>
+
+#include <eosio.system/bancor.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace eosiosystem;
+
+namespace {
+
+   // double precision reference implementations, as found in exchange_state.cpp and delegate_bandwidth.cpp
+
+   int64_t ref_get_output( int64_t inp_reserve, int64_t out_reserve, int64_t inp ) {
+      const double ob = out_reserve;
+      const double ib = inp_reserve;
+      return int64_t( (inp * ob) / (ib + inp) );
+   }
+
+   int64_t ref_get_input( int64_t out_reserve, int64_t inp_reserve, int64_t out ) {
+      const double ob = out_reserve;
+      const double ib = inp_reserve;
+      return int64_t( (ib * out) / (ob - out) );
+   }
+
+   int64_t ref_to_exchange( int64_t supply, int64_t reserve, int64_t payment ) {
+      const double R  = reserve;
+      const double S  = supply;
+      const double dS = S * ( std::pow( 1. + double(payment) / R, .5 ) - 1. );
+      return int64_t(dS);
+   }
+
+   int64_t ref_from_exchange( int64_t supply, int64_t reserve, int64_t tokens ) {
+      const double R  = reserve;
+      const double S  = supply;
+      const double dR = R * ( std::pow( 1. - double(tokens) / S, 2. ) - 1. );
+      return int64_t(-dR);
+   }
+
+   int64_t ref_add_ram_fee( int64_t cost ) {
+      return int64_t( cost / double(0.995) );
+   }
+
+   // RAMCORE supply set up by `init` and reserves/amounts spanning 1 unit to 10^13 (one billion tokens with precision 4)
+   const int64_t ramcore_supply = 100000000000000ll;
+
+   std::vector<int64_t> magnitudes() {
+      std::vector<int64_t> v;
+      for ( int64_t x = 1; x <= 10000000000000ll; x = x * 3 + 1 ) {
+         v.push_back( x );
+      }
+      return v;
+   }
+
+   // units are only meaningful where the double reference is exact to one unit
+   bool representable( double v ) {
+      return v >= 0 && v < double(1ll << 53);
+   }
+
+   template<typename F>
+   double time_ns( F&& f, uint64_t iterations ) {
+      const auto start = std::chrono::steady_clock::now();
+      for ( uint64_t i = 0; i < iterations; ++i ) {
+         f( i );
+      }
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      return std::chrono::duration<double, std::nano>( elapsed ).count() / iterations;
+   }
+
+   volatile int64_t sink = 0;
+
+}
+
+BOOST_AUTO_TEST_SUITE(bancor_tests)
+
+BOOST_AUTO_TEST_CASE( isqrt ) try {
+   for ( uint64_t n = 0; n < 1000000; ++n ) {
+      const bancor::uint128 r = bancor::isqrt( n );
+      BOOST_REQUIRE( r * r <= n && (r + 1) * (r + 1) > n );
+   }
+   for ( int b = 1; b < 128; ++b ) {
+      for ( bancor::uint128 n : { (bancor::uint128(1) << b) - 1, bancor::uint128(1) << b, (bancor::uint128(1) << b) + 1 } ) {
+         const bancor::uint128 r = bancor::isqrt( n );
+         BOOST_REQUIRE( r * r <= n && (r + 1) * (r + 1) > n );
+      }
+   }
+   BOOST_REQUIRE_EQUAL( std::numeric_limits<uint64_t>::max(), bancor::isqrt( ~bancor::uint128(0) ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( differential ) try {
+   const auto values = magnitudes();
+   int64_t worst_output = 0, worst_input = 0, worst_to = 0, worst_from = 0, worst_fee = 0;
+
+   for ( int64_t reserve : values ) {
+      for ( int64_t amount : values ) {
+         const int64_t other = reserve * 3 + 7;
+
+         if ( representable( double(amount) * other / (double(reserve) + amount) ) ) {
+            worst_output = std::max( worst_output, std::abs( bancor::get_output( reserve, other, amount ) - ref_get_output( reserve, other, amount ) ) );
+         }
+         if ( amount >= other ) {
+            BOOST_REQUIRE_EQUAL( std::numeric_limits<int64_t>::max(), bancor::get_input( other, reserve, amount ) );
+         } else if ( representable( double(reserve) * amount / (double(other) - amount) ) ) {
+            worst_input = std::max( worst_input, std::abs( bancor::get_input( other, reserve, amount ) - ref_get_input( other, reserve, amount ) ) );
+         }
+
+         if ( representable( double(ramcore_supply) * ( std::sqrt( 1. + double(amount) / reserve ) - 1. ) ) ) {
+            worst_to = std::max( worst_to, std::abs( bancor::half_weight_to_exchange( ramcore_supply, reserve, amount ) - ref_to_exchange( ramcore_supply, reserve, amount ) ) );
+         }
+         worst_from = std::max( worst_from, std::abs( bancor::half_weight_from_exchange( ramcore_supply, reserve, amount ) - ref_from_exchange( ramcore_supply, reserve, amount ) ) );
+      }
+      worst_fee = std::max( worst_fee, std::abs( bancor::add_ram_fee( reserve ) - ref_add_ram_fee( reserve ) ) );
+   }
+
+   BOOST_TEST_MESSAGE( "worst deviation from double precision: output " << worst_output << ", input " << worst_input
+                       << ", to_exchange " << worst_to << ", from_exchange " << worst_from << ", ram fee " << worst_fee );
+
+   BOOST_REQUIRE_LE( worst_output, 1 );
+   BOOST_REQUIRE_LE( worst_input,  1 );
+   BOOST_REQUIRE_LE( worst_to,     3 );
+   BOOST_REQUIRE_LE( worst_from,   3 );
+   BOOST_REQUIRE_LE( worst_fee,    1 );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( degenerate_markets ) try {
+   BOOST_REQUIRE_EQUAL( 0, bancor::get_output( 0, 1000, 0 ) );
+   BOOST_REQUIRE_EQUAL( 0, bancor::get_output( 1000, 1000, 0 ) );
+   BOOST_REQUIRE_EQUAL( std::numeric_limits<int64_t>::max(), bancor::get_input( 1000, 1000, 1000 ) );
+   BOOST_REQUIRE_EQUAL( 0, bancor::half_weight_to_exchange( ramcore_supply, 0, 1000 ) );
+   BOOST_REQUIRE_EQUAL( 0, bancor::half_weight_from_exchange( ramcore_supply, 1000, 0 ) );
+   BOOST_REQUIRE_EQUAL( 1000, bancor::half_weight_from_exchange( ramcore_supply, 1000, ramcore_supply ) );
+   BOOST_REQUIRE_EQUAL( std::numeric_limits<int64_t>::max(), bancor::add_ram_fee( std::numeric_limits<int64_t>::max() ) );
+} FC_LOG_AND_RETHROW()
+
+// host side comparison only, the contract itself runs the double version through softfloat which is considerably slower
+BOOST_AUTO_TEST_CASE( benchmark ) try {
+   const uint64_t iterations = 1000000;
+   const int64_t  reserve    = 10000000000ll;
+   const int64_t  ram        = 64ll * 1024 * 1024 * 1024;
+
+   const double fixed_output = time_ns( []( uint64_t i ) { sink = bancor::get_output( ram, reserve, 1000 + i ); }, iterations );
+   const double float_output = time_ns( []( uint64_t i ) { sink = ref_get_output( ram, reserve, 1000 + i ); }, iterations );
+   const double fixed_input  = time_ns( []( uint64_t i ) { sink = bancor::get_input( ram, reserve, 1000 + i ); }, iterations );
+   const double float_input  = time_ns( []( uint64_t i ) { sink = ref_get_input( ram, reserve, 1000 + i ); }, iterations );
+   const double fixed_to     = time_ns( []( uint64_t i ) { sink = bancor::half_weight_to_exchange( ramcore_supply, reserve, 1000 + i ); }, iterations );
+   const double float_to     = time_ns( []( uint64_t i ) { sink = ref_to_exchange( ramcore_supply, reserve, 1000 + i ); }, iterations );
+   const double fixed_from   = time_ns( []( uint64_t i ) { sink = bancor::half_weight_from_exchange( ramcore_supply, reserve, 1000 + i ); }, iterations );
+   const double float_from   = time_ns( []( uint64_t i ) { sink = ref_from_exchange( ramcore_supply, reserve, 1000 + i ); }, iterations );
+
+   BOOST_REQUIRE( fixed_output > 0 && fixed_input > 0 && fixed_to > 0 && fixed_from > 0 );
+   BOOST_TEST_MESSAGE( "ns/call fixed vs double: get_output " << fixed_output << " / " << float_output
+                       << ", get_input " << fixed_input << " / " << float_input
+                       << ", to_exchange " << fixed_to << " / " << float_to
+                       << ", from_exchange " << fixed_from << " / " << float_from );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <eosio/chain/trace.hpp>
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace eosio_benchmark {
+
+using namespace eosio::chain;
+
+/**
+ * Collects the resources billed to each benchmarked action:
+ *   cpu_us    - CPU time billed to the transaction, which must be measured by the chain rather than billed explicitly
+ *   net_bytes - NET usage billed to the transaction
+ *   ram_bytes - net change of the RAM usage of all accounts over the action and the inline actions it sent
+ * Every benchmarked action is pushed in a transaction of its own, so the transaction totals are the cost of the action;
+ * the few actions that cannot succeed alone are recorded with the actions they need in the same transaction.
+ *
+ * The report lists the p50, p90, p99 and max of every metric per `contract::action`. When compared with the report
+ * of a previous run, the p50 of every metric is checked; CPU time is measured, NET and RAM are deterministic.
+ */
+class action_benchmark {
+public:
+   static constexpr const char* metrics[] = { "cpu_us", "net_bytes", "ram_bytes" };
+
+   void record( const std::string& contract, const name& act, const transaction_trace_ptr& trace ) {
+      int64_t ram = 0;
+      for ( const auto& at : trace->action_traces ) {
+         for ( const auto& d : at.account_ram_deltas ) {
+            ram += d.delta;
+         }
+      }
+      auto& s = samples[contract + "::" + act.to_string()];
+      s[0].push_back( trace->receipt->cpu_usage_us );
+      s[1].push_back( int64_t( trace->net_usage ) );
+      s[2].push_back( ram );
+   }
+
+   bool empty() const { return samples.empty(); }
+
+   /// Reports the actions of `contracts`, or of every contract when it is empty
+   fc::variant report( const fc::variant_object& run, const std::set<std::string>& contracts = {} ) const {
+      fc::mutable_variant_object actions;
+      for ( const auto& [key, s] : samples ) {
+         if ( !contracts.empty() && !contracts.count( key.substr( 0, key.find( "::" ) ) ) ) {
+            continue;
+         }
+         fc::mutable_variant_object entry;
+         entry( "count", s[0].size() );
+         for ( size_t m = 0; m < s.size(); ++m ) {
+            entry( metrics[m], summarize( s[m] ) );
+         }
+         actions( key, std::move(entry) );
+      }
+      return fc::mutable_variant_object( run )( "actions", std::move(actions) );
+   }
+
+   /**
+    * Returns a description of every p50 in `report` that exceeds the same p50 in `baseline` by more than the
+    * threshold of its metric, in percent of its magnitude; `threshold_pct` is indexed like `metrics`, so that the
+    * measured CPU time can be given more slack than NET and RAM. Actions missing from either report are not compared.
+    */
+   static std::vector<std::string> regressions( const fc::variant& report, const fc::variant& baseline,
+                                                const std::array<double, std::size(metrics)>& threshold_pct ) {
+      std::vector<std::string> result;
+      const auto& current  = report["actions"].get_object();
+      const auto& previous = baseline["actions"].get_object();
+      for ( const auto& entry : current ) {
+         if ( !previous.contains( entry.key().c_str() ) ) {
+            continue;
+         }
+         for ( size_t m = 0; m < std::size(metrics); ++m ) {
+            const char* metric   = metrics[m];
+            const int64_t now    = entry.value()[metric]["p50"].as_int64();
+            const int64_t before = previous[entry.key()][metric]["p50"].as_int64();
+            if ( double(now) > double(before) + std::abs( double(before) ) * threshold_pct[m] / 100 ) {
+               result.push_back( entry.key() + " " + metric + " p50 " + std::to_string( now ) + ", baseline " + std::to_string( before ) );
+            }
+         }
+      }
+      return result;
+   }
+
+private:
+   static fc::mutable_variant_object summarize( std::vector<int64_t> v ) {
+      std::sort( v.begin(), v.end() );
+      auto percentile = [&]( double p ) -> int64_t {
+         return v.empty() ? 0 : v[ std::min<size_t>( v.size() - 1, size_t( p * v.size() ) ) ];
+      };
+      return fc::mutable_variant_object()
+         ( "p50", percentile( .5 ) )
+         ( "p90", percentile( .9 ) )
+         ( "p99", percentile( .99 ) )
+         ( "max", v.empty() ? 0 : v.back() );
+   }
+
+   std::map<std::string, std::array<std::vector<int64_t>, 3>> samples;
+};
+
+} // namespace eosio_benchmark
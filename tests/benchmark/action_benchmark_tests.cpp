@@ -0,0 +1,578 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/global_property_object.hpp>
+#include <eosio/chain/protocol_feature_manager.hpp>
+#include <fc/io/json.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <tuple>
+
+#include "eosio.system_tester.hpp"
+#include "action_benchmark.hpp"
+
+using namespace eosio_system;
+using namespace eosio_benchmark;
+
+/**
+ * Billed CPU, NET and RAM of the actions of every contract in the repository, measured over a fixed, seeded
+ * workload. eosio.system, eosio.token, eosio.msig and eosio.wrap run on the chain of `eosio_system_tester`;
+ * eosio.bios and lacchain.system each run as the system contract of a chain of their own. Every test case compares
+ * the actions it ran with the report of a previous run; the JSON report of all of them is written when the run ends.
+ * Benchmarked transactions are pushed without an explicit CPU bill, so their CPU time is measured by the chain.
+ *
+ * `newaccount` is measured together with the `buyrambytes` and `delegatebw` that pay for the new account in the same
+ * transaction, since an account created by eosio.system without them fails the transaction.
+ *
+ * Actions that cannot be repeated on a running chain are not part of the workload: `init`, `onblock` (pushed by
+ * the chain), `activate` (all protocol features are already active), the `onerror`, `canceldelay` and `setcode`
+ * notification handlers, and `cnclrexorder` and `bidrefund`, which need queued REX orders or legacy name bid refunds.
+ *
+ * Configured through the environment:
+ *   BENCHMARK_ROUNDS        - rounds of the workload, 5 days of chain time apart (default 10)
+ *   BENCHMARK_SEED          - random seed of the amounts in the workload (default 1)
+ *   BENCHMARK_REPORT        - path of the JSON report (default action_benchmark.json)
+ *   BENCHMARK_BASELINE      - path of the report of a previous run; every action whose p50 exceeds the baseline
+ *                             by more than the threshold fails the run (not compared when unset)
+ *   BENCHMARK_THRESHOLD     - regression threshold of NET and RAM, in percent of the baseline (default 10)
+ *   BENCHMARK_CPU_THRESHOLD - regression threshold of the measured CPU time, in percent of the baseline (default 50)
+ *
+ * The benchmark is not part of the default ctest run; configure the tests with -DRUN_ACTION_BENCHMARK=ON to add it.
+ */
+namespace {
+
+action_benchmark& benchmark() {
+   static action_benchmark b;
+   return b;
+}
+
+uint64_t env_or( const char* var, uint64_t def ) {
+   const char* v = std::getenv( var );
+   return v ? std::strtoull( v, nullptr, 10 ) : def;
+}
+
+/// `len` letters starting at `first` that encode `i`, to build distinct names and symbols in each round
+std::string letters( uint64_t i, size_t len, char first = 'a' ) {
+   std::string s;
+   for ( size_t d = 0; d < len; ++d, i /= 26 ) {
+      s += char( first + i % 26 );
+   }
+   return s;
+}
+
+/// Pushes `actions` in one transaction and records it as a sample of `act`
+transaction_trace_ptr bench( base_tester& t, const std::string& contract, const name& act, vector<action> actions ) {
+   signed_transaction trx;
+   trx.actions = std::move( actions );
+   t.set_transaction_headers( trx );
+   std::set<permission_level> signers;
+   for ( const auto& a : trx.actions ) {
+      signers.insert( a.authorization.begin(), a.authorization.end() );
+   }
+   for ( const auto& auth : signers ) {
+      trx.sign( t.get_private_key( auth.actor, auth.permission.to_string() ), t.control->get_chain_id() );
+   }
+   auto trace = t.push_transaction( trx, fc::time_point::maximum(), 0 );
+   benchmark().record( contract, act, trace );
+   return trace;
+}
+
+transaction_trace_ptr bench( base_tester& t, const std::string& contract, const name& code, const name& act,
+                             const vector<permission_level>& auths, const variant_object& data ) {
+   return bench( t, contract, act, vector<action>{ t.get_action( code, act, auths, data ) } );
+}
+
+transaction_trace_ptr bench( base_tester& t, const std::string& contract, const name& code, const name& act,
+                             const name& actor, const variant_object& data ) {
+   return bench( t, contract, code, act, vector<permission_level>{ { actor, config::active_name } }, data );
+}
+
+/// Two different abis, as passed to the setabi action; the workload alternates them so that every setabi changes the hash
+std::vector<bytes> packed_abis() {
+   std::vector<bytes> abis;
+   for ( const auto& abi : { contracts::token_abi(), contracts::msig_abi() } ) {
+      abis.push_back( fc::raw::pack( fc::json::from_string( abi.data() ).as<abi_def>() ) );
+   }
+   return abis;
+}
+
+fc::variant signing_authority( const public_key_type& key ) {
+   producer_authority auth{ name(), block_signing_authority_v0{ 1, { { key, 1 } } } };
+   return auth.get_abi_variant()["authority"];
+}
+
+fc::mutable_variant_object run_info() {
+   return mvo()
+      ("rounds", env_or( "BENCHMARK_ROUNDS", 10 ))
+      ("seed",   env_or( "BENCHMARK_SEED", 1 ));
+}
+
+/// Fails the current test case for every action of `contracts` that regressed from the baseline report, if one is given
+void check_regressions( const std::set<std::string>& contracts ) {
+   const char* baseline_path = std::getenv( "BENCHMARK_BASELINE" );
+   if ( !baseline_path ) {
+      return;
+   }
+   // CPU time is measured on a loaded machine from a few samples per action, while NET and RAM do not vary
+   const double threshold = env_or( "BENCHMARK_THRESHOLD", 10 ), cpu_threshold = env_or( "BENCHMARK_CPU_THRESHOLD", 50 );
+   const auto baseline = fc::json::from_file( baseline_path );
+   for ( const auto& regression : action_benchmark::regressions( benchmark().report( run_info(), contracts ), baseline,
+                                                                 { cpu_threshold, threshold, threshold } ) ) {
+      BOOST_ERROR( "regression: " << regression );
+   }
+}
+
+/// Writes the report of every test case that ran once the run ends, whichever test cases were selected
+struct benchmark_report {
+   ~benchmark_report() {
+      if ( benchmark().empty() ) {
+         return;
+      }
+      const char* report_path = std::getenv( "BENCHMARK_REPORT" );
+      const std::string path = report_path ? report_path : "action_benchmark.json";
+      fc::json::save_to_file( benchmark().report( run_info() ), path, true );
+      std::cout << "action benchmark report written to " << path << std::endl;
+   }
+};
+
+fc::variant preactivate_feature_digest( const controller& control ) {
+   return fc::variant( *control.get_protocol_feature_manager().get_builtin_digest( builtin_protocol_feature_t::preactivate_feature ) );
+}
+
+} // namespace
+
+class system_benchmark_tester : public eosio_system_tester {
+public:
+
+   system_benchmark_tester() : rng( env_or( "BENCHMARK_SEED", 1 ) ) {
+      initialize_multisig();
+
+      create_account_with_resources( N(eosio.wrap), config::system_account_name );
+      BOOST_REQUIRE_EQUAL( success(), buyram( N(eosio), N(eosio.wrap), core_sym::from_string("5000.0000") ) );
+      base_tester::push_action( config::system_account_name, N(setpriv), config::system_account_name, mvo()
+                                ("account", "eosio.wrap")
+                                ("is_priv", 1)
+      );
+      set_code( N(eosio.wrap), contracts::wrap_wasm() );
+      set_abi( N(eosio.wrap), contracts::wrap_abi().data() );
+
+      cross_15_percent_threshold();
+
+      for ( uint32_t i = 0; i < 8; ++i ) {
+         users.emplace_back( "benchuser" + letters( i, 1 ) );
+      }
+      std::vector<account_name> accounts = users;
+      accounts.insert( accounts.end(), { voter, managed, producer_a, producer_b, proxy_a, proxy_b } );
+      for ( const auto& a : accounts ) {
+         create_account_with_resources( a, config::system_account_name, core_sym::from_string("100.0000"), false,
+                                        core_sym::from_string("1000.0000"), core_sym::from_string("1000.0000") );
+      }
+      produce_block();
+
+      regproducer( producer_a );
+      regproducer( producer_b );
+      BOOST_REQUIRE_EQUAL( success(), push_action( proxy_a, N(regproxy), mvo()("proxy", proxy_a)("isproxy", true) ) );
+      for ( const auto& a : users ) {
+         transfer( config::system_account_name, a, core_sym::from_string("100000.0000"), config::system_account_name );
+         BOOST_REQUIRE_EQUAL( success(), stake( a, a, core_sym::from_string("1000.0000"), core_sym::from_string("1000.0000") ) );
+         BOOST_REQUIRE_EQUAL( success(), vote( a, { }, proxy_a ) );
+         BOOST_REQUIRE_EQUAL( success(), deposit( a, core_sym::from_string("20000.0000") ) );
+         BOOST_REQUIRE_EQUAL( success(), buyrex( a, core_sym::from_string("10000.0000") ) );
+      }
+      transfer( config::system_account_name, voter, core_sym::from_string("100000.0000"), config::system_account_name );
+      BOOST_REQUIRE_EQUAL( success(), stake( voter, voter, core_sym::from_string("1000.0000"), core_sym::from_string("1000.0000") ) );
+
+      // let the REX bought above mature
+      produce_block();
+      produce_block( fc::days(5) );
+   }
+
+   asset core( int64_t min, int64_t max ) {
+      return asset( std::uniform_int_distribution<int64_t>( min, max )( rng ), symbol{CORE_SYM} );
+   }
+
+   int64_t random( int64_t min, int64_t max ) {
+      return std::uniform_int_distribution<int64_t>( min, max )( rng );
+   }
+
+   const account_name& user( uint32_t i ) const { return users[i % users.size()]; }
+
+   transaction_trace_ptr sys( const name& act, const name& actor, const variant_object& data ) {
+      return bench( *this, "eosio.system", config::system_account_name, act, actor, data );
+   }
+
+   transaction_trace_ptr token( const name& act, const name& actor, const variant_object& data ) {
+      return bench( *this, "eosio.token", N(eosio.token), act, actor, data );
+   }
+
+   transaction_trace_ptr msig( const name& act, const name& actor, const variant_object& data ) {
+      return bench( *this, "eosio.msig", N(eosio.msig), act, actor, data );
+   }
+
+   transaction_trace_ptr wrap( const name& act, const name& executer, const variant_object& data ) {
+      return bench( *this, "eosio.wrap", N(eosio.wrap), act,
+                    vector<permission_level>{ { executer, config::active_name }, { N(eosio.wrap), config::active_name } }, data );
+   }
+
+   transaction transfer_trx( const name& from, const name& to, const asset& quantity ) {
+      transaction trx;
+      set_transaction_headers( trx );
+      trx.actions.emplace_back( get_action( N(eosio.token), N(transfer), vector<permission_level>{ { from, config::active_name } },
+                                            mvo()("from", from)("to", to)("quantity", quantity)("memo", "") ) );
+      return trx;
+   }
+
+   void token_actions( uint32_t r ) {
+      const account_name issuer = users[0], a = user( r ), b = user( r + 1 ), c = user( r + 2 );
+      const symbol sym = symbol::from_string( "4,B" + letters( r, 3, 'A' ) );
+
+      token( N(create), N(eosio.token), mvo()("issuer", issuer)("maximum_supply", asset( 1'000'000'000'0000, sym )) );
+      token( N(issue), issuer, mvo()("to", issuer)("quantity", asset( random( 1'000'0000, 10'000'0000 ), sym ))("memo", "issue") );
+      token( N(issuemany), issuer, mvo()("issues", fc::variants({
+                mvo()("to", b)("quantity", asset( random( 1'0000, 100'0000 ), sym ))("memo", "issue"),
+                mvo()("to", c)("quantity", asset( random( 1'0000, 100'0000 ), sym ))("memo", "issue") })) );
+      token( N(retire), issuer, mvo()("quantity", asset( random( 1, 1'0000 ), sym ))("memo", "retire") );
+      token( N(transfer), b, mvo()("from", b)("to", c)("quantity", asset( random( 1, 1'0000 ), sym ))("memo", "") );
+      token( N(open), voter, mvo()("owner", voter)("symbol", sym)("ram_payer", voter) );
+      token( N(close), voter, mvo()("owner", voter)("symbol", sym) );
+      token( N(getsupply), a, mvo()("sym", sym.name()) );
+      token( N(getbalance), a, mvo()("owner", b)("sym", sym.name()) );
+      token( N(setcompact), N(eosio.token), mvo()("sym", sym.name()) );
+      token( N(transfer), c, mvo()("from", c)("to", b)("quantity", asset( random( 1, 1'0000 ), sym ))("memo", "compact") );
+
+      token( N(transfer), a, mvo()("from", a)("to", b)("quantity", core( 1, 100'0000 ))("memo", "") );
+      token( N(transfers), a, mvo()("from", a)("transfers", fc::variants({
+                mvo()("to", b)("quantity", core( 1, 100'0000 ))("memo", ""),
+                mvo()("to", c)("quantity", core( 1, 100'0000 ))("memo", "") })) );
+   }
+
+   void resource_actions( uint32_t r ) {
+      const account_name a = user( r ), b = user( r + 1 ), c = user( r + 2 );
+
+      // the refunds requested in the previous round are due
+      if ( r > 0 ) {
+         sys( N(procrefunds), a, mvo()("owners", std::vector<account_name>{ a, b }) );
+         sys( N(refund), c, mvo()("owner", c) );
+      }
+
+      sys( N(buyram), a, mvo()("payer", a)("receiver", b)("quant", core( 1, 10'0000 )) );
+      sys( N(buyrambytes), a, mvo()("payer", a)("receiver", a)("bytes", random( 100, 10000 )) );
+      sys( N(buyramfor), a, mvo()("payer", a)("purchases", fc::variants({
+              mvo()("receiver", b)("quant", core( 1, 10'0000 )),
+              mvo()("receiver", c)("quant", core( 1, 10'0000 )) })) );
+      sys( N(sellram), a, mvo()("account", a)("bytes", random( 100, 1000 )) );
+      sys( N(quoteram), a, mvo()("quantity", core( 1'0000, 100'0000 )) );
+
+      sys( N(delegatebw), a, mvo()
+           ("from", a)("receiver", b)("stake_net_quantity", core( 1, 10'0000 ))("stake_cpu_quantity", core( 1, 10'0000 ))("transfer", false) );
+      sys( N(delegatebws), a, mvo()("from", a)("deltas", fc::variants({
+              mvo()("receiver", b)("net_delta", core( 1, 10'0000 ))("cpu_delta", core( 1, 10'0000 )),
+              mvo()("receiver", c)("net_delta", core( 1, 10'0000 ))("cpu_delta", core( 1, 10'0000 )) })) );
+      for ( const auto& u : users ) {
+         sys( N(undelegatebw), u, mvo()
+              ("from", u)("receiver", u)("unstake_net_quantity", core( 1, 1'0000 ))("unstake_cpu_quantity", core( 1, 1'0000 )) );
+      }
+   }
+
+   void rex_actions( uint32_t r ) {
+      const account_name a = user( r ), b = user( r + 1 );
+      const symbol rex_sym = symbol::from_string( "4,REX" );
+
+      sys( N(deposit), a, mvo()("owner", a)("amount", core( 1, 100'0000 )) );
+      sys( N(withdraw), a, mvo()("owner", a)("amount", core( 1, 1'0000 )) );
+      sys( N(buyrex), a, mvo()("from", a)("amount", core( 1, 100'0000 )) );
+      sys( N(sellrex), a, mvo()("from", a)("rex", asset( random( 10'0000, 100'0000 ), rex_sym )) );
+      sys( N(unstaketorex), a, mvo()("owner", a)("receiver", a)("from_net", core( 1, 100 ))("from_cpu", core( 1, 100 )) );
+      sys( N(mvtosavings), a, mvo()("owner", a)("rex", asset( random( 10'0000, 100'0000 ), rex_sym )) );
+      sys( N(mvfrsavings), a, mvo()("owner", a)("rex", asset( random( 1'0000, 10'0000 ), rex_sym )) );
+      sys( N(consolidate), a, mvo()("owner", a) );
+      sys( N(updaterex), a, mvo()("owner", a) );
+      sys( N(quoterex), a, mvo()("quantity", core( 1, 100'0000 )) );
+      sys( N(quoteloan), a, mvo()("loan_payment", core( 1, 1'0000 )) );
+
+      for ( auto [rent, fund, defund] : { std::make_tuple( N(rentcpu), N(fundcpuloan), N(defcpuloan) ),
+                                          std::make_tuple( N(rentnet), N(fundnetloan), N(defnetloan) ) } ) {
+         const asset payment = core( 1, 1'0000 );
+         sys( rent, a, mvo()("from", a)("receiver", b)("loan_payment", payment)("loan_fund", payment) );
+         const uint64_t loan_num = get_rex_pool()["loan_num"].as<uint64_t>();
+         sys( fund, a, mvo()("from", a)("loan_num", loan_num)("payment", core( 1, 1'0000 )) );
+         sys( defund, a, mvo()("from", a)("loan_num", loan_num)("amount", core( 1, 1 )) );
+      }
+      sys( N(rexexec), a, mvo()("user", a)("max", 2) );
+
+      // an account that holds no REX opens a REX fund and closes it again
+      const asset amount = core( 1, 100'0000 );
+      sys( N(deposit), voter, mvo()("owner", voter)("amount", amount) );
+      sys( N(withdraw), voter, mvo()("owner", voter)("amount", amount) );
+      sys( N(closerex), voter, mvo()("owner", voter) );
+   }
+
+   void voting_actions( uint32_t r ) {
+      const account_name a = user( r ), b = user( r + 1 );
+
+      sys( N(regproducer), producer_b, mvo()
+           ("producer", producer_b)("producer_key", get_public_key( producer_b, "active" ))("url", "https://" + letters( r, 4 ))("location", random( 0, 999 )) );
+      sys( N(voteproducer), voter, mvo()
+           ("voter", voter)("proxy", name(0))("producers", r % 2 ? vector<account_name>{ producer_a, producer_b } : vector<account_name>{ producer_a }) );
+      sys( N(unregprod), producer_b, mvo()("producer", producer_b) );
+      sys( N(regproducer2), producer_b, mvo()
+           ("producer", producer_b)("producer_authority", signing_authority( get_public_key( producer_b, "active" ) ))
+           ("url", "https://" + letters( r, 4 ))("location", random( 0, 999 )) );
+      sys( N(rmvproducer), config::system_account_name, mvo()("producer", producer_b) );
+      sys( N(claimrewards), producer_a, mvo()("owner", producer_a) );
+
+      sys( N(regproxy), proxy_b, mvo()("proxy", proxy_b)("isproxy", true) );
+      sys( N(regproxy), proxy_b, mvo()("proxy", proxy_b)("isproxy", false) );
+
+      const account_name newname( "bench" + letters( r, 4 ) );
+      const asset bid = core( 1'0000, 10'0000 );
+      sys( N(bidname), a, mvo()("bidder", a)("newname", newname)("bid", bid) );
+      sys( N(bidname), b, mvo()("bidder", b)("newname", newname)("bid", bid + bid) );
+      sys( N(claimbidrefs), a, mvo()("bidder", a) );
+   }
+
+   void privileged_actions( uint32_t r ) {
+      const name eosio = config::system_account_name;
+
+      if ( r == 0 ) {
+         sys( N(updtrevision), eosio, mvo()("revision", 1) );
+      }
+      sys( N(setram), eosio, mvo()("max_ram_size", get_global_state()["max_ram_size"].as<uint64_t>() + random( 1, 1 << 20 )) );
+      sys( N(setramrate), eosio, mvo()("bytes_per_block", random( 1, 1000 )) );
+      sys( N(setparams), eosio, mvo()("params", control->get_global_properties().configuration) );
+      sys( N(setinflation), eosio, mvo()("annual_rate", random( 0, 1000 ))("inflation_pay_factor", 50000)("votepay_factor", 40000) );
+      sys( N(setrex), eosio, mvo()("balance", get_rex_pool()["total_rent"].as<asset>()) );
+      sys( N(setpriv), eosio, mvo()("account", voter)("is_priv", 1) );
+      sys( N(setpriv), eosio, mvo()("account", voter)("is_priv", 0) );
+      sys( N(setalimits), eosio, mvo()("account", "eosio.vpay")("ram_bytes", -1)("net_weight", random( 1, 1000 ))("cpu_weight", random( 1, 1000 )) );
+      sys( N(setacctram), eosio, mvo()("account", managed)("ram_bytes", random( 1 << 20, 2 << 20 )) );
+      sys( N(setacctnet), eosio, mvo()("account", managed)("net_weight", random( 1, 1000 )) );
+      sys( N(setacctcpu), eosio, mvo()("account", managed)("cpu_weight", random( 1, 1000 )) );
+   }
+
+   void account_actions( uint32_t r ) {
+      const name eosio = config::system_account_name;
+      const account_name a = user( r ), acct( "benchacct" + letters( r, 3 ) );
+      const bytes& abi = abis[r % abis.size()];
+
+      bench( *this, "eosio.system", N(newaccount), vector<action>{
+         get_action( eosio, N(newaccount), vector<permission_level>{ { a, config::active_name } }, mvo()
+                     ("creator", a)("name", acct)
+                     ("owner", authority( get_public_key( acct, "owner" ) ))("active", authority( get_public_key( acct, "active" ) )) ),
+         get_action( eosio, N(buyrambytes), vector<permission_level>{ { a, config::active_name } }, mvo()
+                     ("payer", a)("receiver", acct)("bytes", 16 * 1024) ),
+         get_action( eosio, N(delegatebw), vector<permission_level>{ { a, config::active_name } }, mvo()
+                     ("from", a)("receiver", acct)("stake_net_quantity", core_sym::from_string("10.0000"))
+                     ("stake_cpu_quantity", core_sym::from_string("10.0000"))("transfer", false) ) } );
+
+      sys( N(updateauth), acct, mvo()
+           ("account", acct)("permission", "bench")("parent", "active")("auth", authority( get_public_key( acct, "bench" ) )) );
+      sys( N(linkauth), acct, mvo()("account", acct)("code", "eosio.token")("type", "transfer")("requirement", "bench") );
+      sys( N(unlinkauth), acct, mvo()("account", acct)("code", "eosio.token")("type", "transfer") );
+      sys( N(deleteauth), acct, mvo()("account", acct)("permission", "bench") );
+      sys( N(setabi), acct, mvo()("account", acct)("abi", abi) );
+   }
+
+   void msig_actions( uint32_t r ) {
+      const account_name a = user( r ), b = user( r + 1 ), c = user( r + 2 );
+      const name executed( "p" + letters( r, 4 ) ), canceled( "c" + letters( r, 4 ) ), expiring( "x" + letters( r, 4 ) );
+      const auto trx = transfer_trx( b, a, core( 1, 100 ) );
+      const vector<permission_level> requested{ { b, config::active_name }, { c, config::active_name } };
+
+      // the proposals left to expire in the previous round are purged
+      if ( r > 0 ) {
+         msig( N(purge), a, mvo()("max", 10) );
+      }
+      for ( const auto& proposal : { executed, canceled, expiring } ) {
+         msig( N(propose), a, mvo()("proposer", a)("proposal_name", proposal)("requested", requested)("trx", trx) );
+      }
+      msig( N(approve), b, mvo()("proposer", a)("proposal_name", executed)("level", permission_level{ b, config::active_name }) );
+      msig( N(approvemany), c, mvo()
+            ("level",    permission_level{ c, config::active_name })
+            ("requests", fc::variants({
+               mvo()("proposer", a)("proposal_name", executed)("proposal_hash", fc::variant()),
+               mvo()("proposer", a)("proposal_name", expiring)("proposal_hash", fc::variant()) })) );
+      msig( N(unapprove), c, mvo()("proposer", a)("proposal_name", executed)("level", permission_level{ c, config::active_name }) );
+      msig( N(exec), a, mvo()("proposer", a)("proposal_name", executed)("executer", a) );
+      msig( N(cancel), a, mvo()("proposer", a)("proposal_name", canceled)("canceler", a) );
+      msig( N(invalidate), c, mvo()("account", c) );
+   }
+
+   void wrap_actions( uint32_t r ) {
+      const account_name a = user( r ), b = user( r + 1 ), c = user( r + 2 );
+
+      wrap( N(exec), a, mvo()("executer", a)("trx", transfer_trx( a, b, core( 1, 100 ) )) );
+      wrap( N(execmany), a, mvo()("executer", a)("trxs", vector<transaction>{ transfer_trx( a, b, core( 1, 100 ) ),
+                                                                               transfer_trx( a, c, core( 1, 100 ) ) }) );
+   }
+
+   std::mt19937_64           rng;
+   std::vector<account_name> users;
+   const account_name        voter      = N(benchvoter);
+   const account_name        managed    = N(benchmanaged);
+   const account_name        producer_a = N(benchproda);
+   const account_name        producer_b = N(benchprodb);
+   const account_name        proxy_a    = N(benchproxya);
+   const account_name        proxy_b    = N(benchproxyb);
+   std::vector<bytes>        abis       = packed_abis();
+};
+
+class bios_benchmark_tester : public tester {
+public:
+
+   bios_benchmark_tester() : rng( env_or( "BENCHMARK_SEED", 1 ) ) {
+      set_code( config::system_account_name, contracts::bios_wasm() );
+      set_abi( config::system_account_name, contracts::bios_abi().data() );
+      produce_block();
+   }
+
+   transaction_trace_ptr bios( const name& act, const name& actor, const variant_object& data ) {
+      return bench( *this, "eosio.bios", config::system_account_name, act, actor, data );
+   }
+
+   int64_t random( int64_t min, int64_t max ) {
+      return std::uniform_int_distribution<int64_t>( min, max )( rng );
+   }
+
+   void actions( uint32_t r ) {
+      const name eosio = config::system_account_name;
+      const account_name acct( "biosacct" + letters( r, 4 ) );
+      const bytes& abi = abis[r % abis.size()];
+
+      bios( N(newaccount), eosio, mvo()
+            ("creator", eosio)("name", acct)("owner", authority( get_public_key( acct, "owner" ) ))("active", authority( get_public_key( acct, "active" ) )) );
+      bios( N(updateauth), acct, mvo()
+            ("account", acct)("permission", "bench")("parent", "active")("auth", authority( get_public_key( acct, "bench" ) )) );
+      bios( N(linkauth), acct, mvo()("account", acct)("code", eosio)("type", "reqauth")("requirement", "bench") );
+      bios( N(unlinkauth), acct, mvo()("account", acct)("code", eosio)("type", "reqauth") );
+      bios( N(deleteauth), acct, mvo()("account", acct)("permission", "bench") );
+      bios( N(setabi), acct, mvo()("account", acct)("abi", abi) );
+      bios( N(reqauth), acct, mvo()("from", acct) );
+
+      bios( N(setpriv), eosio, mvo()("account", acct)("is_priv", 1) );
+      bios( N(setpriv), eosio, mvo()("account", acct)("is_priv", 0) );
+      bios( N(setalimits), eosio, mvo()("account", acct)("ram_bytes", -1)("net_weight", random( 1, 1000 ))("cpu_weight", random( 1, 1000 )) );
+      bios( N(bootstrap), eosio, mvo()
+            ("limits",     fc::variants({ mvo()("account", acct)("ram_bytes", -1)("net_weight", random( 1, 1000 ))("cpu_weight", random( 1, 1000 )) }))
+            ("privileges", fc::variants({ mvo()("account", acct)("is_priv", false) }))
+            ("abi_hashes", fc::variants({ mvo()("account", acct)("hash", fc::sha256::hash( abi.data(), abi.size() ))("size", abi.size()) })) );
+      bios( N(setparams), eosio, mvo()("params", control->get_global_properties().configuration) );
+      bios( N(setprods), eosio, mvo()("schedule", fc::variants({
+               producer_authority{ eosio, block_signing_authority_v0{ 1, { { get_public_key( eosio, "active" ), 1 } } } }.get_abi_variant() })) );
+      bios( N(reqactivated), eosio, mvo()("feature_digest", preactivate_feature_digest( *control )) );
+   }
+
+   std::mt19937_64    rng;
+   std::vector<bytes> abis = packed_abis();
+};
+
+class lacchain_benchmark_tester : public tester {
+public:
+
+   lacchain_benchmark_tester() : rng( env_or( "BENCHMARK_SEED", 1 ) ) {
+      // once lacchain.system is set, only entities can be created by the system account
+      create_accounts( { user } );
+      set_code( config::system_account_name, contracts::lacchain_wasm() );
+      set_abi( config::system_account_name, contracts::lacchain_abi().data() );
+
+      // the first writer owns the `writer@access` permission that the accounts created by writers are bound to
+      push_action( config::system_account_name, N(addwriter), config::system_account_name, entity( "writer", N(writer) ) );
+      produce_block();
+   }
+
+   transaction_trace_ptr lacchain( const name& act, const name& actor, const variant_object& data ) {
+      return bench( *this, "lacchain.system", config::system_account_name, act, actor, data );
+   }
+
+   int64_t random( int64_t min, int64_t max ) {
+      return std::uniform_int_distribution<int64_t>( min, max )( rng );
+   }
+
+   fc::mutable_variant_object entity( const char* field, const account_name& n ) {
+      return mvo()
+         (field,      n)
+         ("owner",    authority( get_public_key( n, "owner" ) ))
+         ("active",   authority( get_public_key( n, "active" ) ))
+         ("location", random( 0, 999 ));
+   }
+
+   void actions( uint32_t r ) {
+      const name eosio = config::system_account_name;
+      const std::string suffix = letters( r, 4 );
+      const account_name validator( "val" + suffix ), writer( "wrt" + suffix ), boot( "boot" + suffix ),
+                         observer( "obs" + suffix ), account( "user" + suffix );
+
+      lacchain( N(addvalidator), eosio, entity( "validator", validator )
+                ("validator_authority", signing_authority( get_public_key( validator, "active" ) )) );
+      lacchain( N(addwriter), eosio, entity( "writer", writer ) );
+      lacchain( N(addboot), eosio, entity( "boot", boot ) );
+      lacchain( N(addobserver), eosio, entity( "observer", observer ) );
+      lacchain( N(addnetlink), eosio, mvo()("entityA", validator)("entityB", boot)("direction", 1) );
+      lacchain( N(rmnetlink), eosio, mvo()("entityA", validator)("entityB", boot) );
+
+      // an account created by a writer is controlled by its key together with `writer@access`
+      const authority account_auth( 2, { key_weight{ get_public_key( account, "active" ), 1 } },
+                                    { permission_level_weight{ { N(writer), N(access) }, 1 } } );
+      lacchain( N(newaccount), N(writer), mvo()("creator", "writer")("name", account)("owner", account_auth)("active", account_auth) );
+
+      lacchain( N(setabi), user, mvo()("account", user)("abi", abis[r % abis.size()]) );
+      lacchain( N(reqauth), user, mvo()("from", user) );
+      lacchain( N(setpriv), eosio, mvo()("account", observer)("is_priv", 1) );
+      lacchain( N(setpriv), eosio, mvo()("account", observer)("is_priv", 0) );
+      lacchain( N(setalimits), eosio, mvo()("account", observer)("ram_bytes", 1 << 20)("net_weight", random( 1, 1000 ))("cpu_weight", random( 1, 1000 )) );
+      lacchain( N(setparams), eosio, mvo()("params", control->get_global_properties().configuration) );
+      lacchain( N(reqactivated), eosio, mvo()("feature_digest", preactivate_feature_digest( *control )) );
+
+      block_signing_private_keys.emplace( get_public_key( validator, "active" ), get_private_key( validator, "active" ) );
+      lacchain( N(setschedule), eosio, mvo()("validators", vector<account_name>{ validator }) );
+   }
+
+   std::mt19937_64    rng;
+   const account_name user = N(benchuser);
+   std::vector<bytes> abis = packed_abis();
+};
+
+BOOST_GLOBAL_FIXTURE( benchmark_report );
+
+BOOST_AUTO_TEST_SUITE(action_benchmark_tests)
+
+BOOST_FIXTURE_TEST_CASE( system_contracts, system_benchmark_tester ) try {
+   const uint64_t rounds = env_or( "BENCHMARK_ROUNDS", 10 );
+   for ( uint32_t r = 0; r < rounds; ++r ) {
+      token_actions( r );
+      resource_actions( r );
+      rex_actions( r );
+      voting_actions( r );
+      privileged_actions( r );
+      account_actions( r );
+      msig_actions( r );
+      wrap_actions( r );
+
+      // executes the transactions scheduled by eosio.msig and eosio.wrap before moving on
+      produce_block();
+      produce_block( fc::days(5) );
+   }
+   check_regressions( { "eosio.system", "eosio.token", "eosio.msig", "eosio.wrap" } );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( bios_contract, bios_benchmark_tester ) try {
+   const uint64_t rounds = env_or( "BENCHMARK_ROUNDS", 10 );
+   for ( uint32_t r = 0; r < rounds; ++r ) {
+      actions( r );
+      produce_block();
+   }
+   check_regressions( { "eosio.bios" } );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( lacchain_contract, lacchain_benchmark_tester ) try {
+   const uint64_t rounds = env_or( "BENCHMARK_ROUNDS", 10 );
+   for ( uint32_t r = 0; r < rounds; ++r ) {
+      actions( r );
+      produce_block();
+   }
+   check_regressions( { "lacchain.system" } );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
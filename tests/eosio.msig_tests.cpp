@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 #include <eosio/testing/tester.hpp>
 #include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
 
 #include <Runtime/Runtime.h>
@@ -145,6 +146,40 @@ public:
       */
    }
 
+   fc::variant get_approvals( account_name proposer, account_name proposal_name ) {
+      vector<char> data = get_row_by_account( N(eosio.msig), proposer, N(approvals2), proposal_name );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "approvals_info", data, abi_serializer_max_time );
+   }
+
+   fc::variant get_proposal( account_name proposer, account_name proposal_name ) {
+      vector<char> data = get_row_by_account( N(eosio.msig), proposer, N(proposal), proposal_name );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "proposal", data, abi_serializer_max_time );
+   }
+
+   // overwrites a row in place, e.g. to recreate rows written by older versions of the contract
+   void set_row( account_name proposer, account_name table, account_name proposal_name, const vector<char>& data ) {
+      auto& db = control->mutable_db();
+      const auto& t = db.get<table_id_object, by_code_scope_table>( boost::make_tuple( N(eosio.msig), proposer, table ) );
+      const auto& row = db.get<key_value_object, by_scope_primary>( boost::make_tuple( t.id, proposal_name.to_uint64_t() ) );
+      db.modify( row, [&]( auto& o ) {
+         o.value.assign( data.data(), data.size() );
+      });
+   }
+
+   void set_approvals( account_name proposer, account_name proposal_name, const fc::variant& info ) {
+      const auto data = abi_ser.variant_to_binary( "approvals_info", info, abi_serializer_max_time );
+      BOOST_REQUIRE_EQUAL( get_row_by_account( N(eosio.msig), proposer, N(approvals2), proposal_name ).size(), data.size() );
+      set_row( proposer, N(approvals2), proposal_name, data );
+   }
+
+   static vector<account_name> approval_actors( const fc::variant& approvals ) {
+      vector<account_name> actors;
+      for ( const auto& a : approvals.get_array() ) {
+         actors.push_back( a["level"]["actor"].as<account_name>() );
+      }
+      return actors;
+   }
+
    transaction reqauth( account_name from, const vector<permission_level>& auths, const fc::microseconds& max_serialization_time );
 
    abi_serializer abi_ser;
@@ -919,6 +954,9 @@ BOOST_FIXTURE_TEST_CASE( approve_with_hash, eosio_msig_tester ) try {
                   ("trx",           trx)
                   ("requested", vector<permission_level>{{ N(alice), config::active_name }})
    );
+   auto prop = get_proposal( N(alice), N(first) );
+   BOOST_REQUIRE( fc::raw::pack( trx ) == prop["packed_transaction"].as<bytes>() );
+   BOOST_REQUIRE( trx_hash == prop["trx_hash"].as<fc::sha256>() );
 
    //fail to approve with incorrect hash
    BOOST_REQUIRE_EXCEPTION( push_action( N(alice), N(approve), mvo()
@@ -927,8 +965,8 @@ BOOST_FIXTURE_TEST_CASE( approve_with_hash, eosio_msig_tester ) try {
                                           ("level",         permission_level{ N(alice), config::active_name })
                                           ("proposal_hash", not_trx_hash)
                             ),
-                            eosio::chain::crypto_api_exception,
-                            fc_exception_message_is("hash mismatch")
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("hash mismatch")
    );
 
    //approve and execute
@@ -957,6 +995,135 @@ BOOST_FIXTURE_TEST_CASE( approve_with_hash, eosio_msig_tester ) try {
    BOOST_REQUIRE_EQUAL( transaction_receipt::executed, trace->receipt->status );
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( approve_with_hash_without_stored_hash, eosio_msig_tester ) try {
+   auto trx = reqauth( N(alice), {permission_level{N(alice), config::active_name}}, abi_serializer_max_time );
+   auto trx_hash = fc::sha256::hash( trx );
+   auto not_trx_hash = fc::sha256::hash( trx_hash );
+
+   push_action( N(alice), N(propose), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("trx",           trx)
+                  ("requested", vector<permission_level>{{ N(alice), config::active_name }})
+   );
+
+   //recreate a proposal written before the transaction hash was stored
+   auto prop = get_proposal( N(alice), N(first) );
+   set_row( N(alice), N(proposal), N(first), fc::raw::pack( std::make_pair( prop["proposal_name"].as<name>(),
+                                                                            prop["packed_transaction"].as<bytes>() ) ) );
+   BOOST_REQUIRE( !get_proposal( N(alice), N(first) ).get_object().contains( "trx_hash" ) );
+
+   //the transaction is hashed instead
+   BOOST_REQUIRE_EXCEPTION( push_action( N(alice), N(approve), mvo()
+                                          ("proposer",      "alice")
+                                          ("proposal_name", "first")
+                                          ("level",         permission_level{ N(alice), config::active_name })
+                                          ("proposal_hash", not_trx_hash)
+                            ),
+                            eosio::chain::crypto_api_exception,
+                            fc_exception_message_is("hash mismatch")
+   );
+
+   push_action( N(alice), N(approve), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("level",         permission_level{ N(alice), config::active_name })
+                  ("proposal_hash", trx_hash)
+   );
+
+   transaction_trace_ptr trace;
+   control->applied_transaction.connect(
+   [&]( std::tuple<const transaction_trace_ptr&, const signed_transaction&> p ) {
+      const auto& t = std::get<0>(p);
+      if( t->scheduled ) { trace = t; }
+   } );
+
+   push_action( N(alice), N(exec), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("executer",      "alice")
+   );
+
+   BOOST_REQUIRE( bool(trace) );
+   BOOST_REQUIRE_EQUAL( transaction_receipt::executed, trace->receipt->status );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( approve_many, eosio_msig_tester ) try {
+   auto trx = reqauth( N(carol), {permission_level{N(carol), config::active_name}}, abi_serializer_max_time );
+   auto trx_hash = fc::sha256::hash( trx );
+
+   for ( auto proposer : { N(alice), N(bob) } ) {
+      for ( auto proposal_name : { N(first), N(second) } ) {
+         push_action( proposer, N(propose), mvo()
+                        ("proposer",      proposer)
+                        ("proposal_name", proposal_name)
+                        ("trx",           trx)
+                        ("requested", vector<permission_level>{{ N(carol), config::active_name }})
+         );
+      }
+   }
+
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(approvemany), mvo()
+                                          ("level",    permission_level{ N(carol), config::active_name })
+                                          ("requests", fc::variants())
+                            ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("no proposals provided")
+   );
+
+   //all approvals fail together
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(approvemany), mvo()
+                                          ("level",    permission_level{ N(carol), config::active_name })
+                                          ("requests", fc::variants({
+                                             mvo()("proposer", "alice")("proposal_name", "first")("proposal_hash", trx_hash),
+                                             mvo()("proposer", "bob")("proposal_name", "third")("proposal_hash", fc::variant()) }))
+                            ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("proposal not found")
+   );
+   BOOST_REQUIRE( vector<account_name>({}) == approval_actors( get_approvals( N(alice), N(first) )["provided_approvals"] ) );
+
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(approvemany), mvo()
+                                          ("level",    permission_level{ N(carol), config::active_name })
+                                          ("requests", fc::variants({
+                                             mvo()("proposer", "alice")("proposal_name", "first")("proposal_hash", fc::sha256::hash( trx_hash )) }))
+                            ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("hash mismatch")
+   );
+
+   push_action( N(carol), N(approvemany), mvo()
+                  ("level",    permission_level{ N(carol), config::active_name })
+                  ("requests", fc::variants({
+                     mvo()("proposer", "bob")("proposal_name", "second")("proposal_hash", trx_hash),
+                     mvo()("proposer", "alice")("proposal_name", "first")("proposal_hash", trx_hash),
+                     mvo()("proposer", "bob")("proposal_name", "first")("proposal_hash", fc::variant()) }))
+   );
+
+   for ( auto proposer : { N(alice), N(bob) } ) {
+      BOOST_REQUIRE( vector<account_name>({ N(carol) }) == approval_actors( get_approvals( proposer, N(first) )["provided_approvals"] ) );
+   }
+   BOOST_REQUIRE( vector<account_name>({ N(carol) }) == approval_actors( get_approvals( N(bob), N(second) )["provided_approvals"] ) );
+   BOOST_REQUIRE( vector<account_name>({}) == approval_actors( get_approvals( N(alice), N(second) )["provided_approvals"] ) );
+
+   //a proposal cannot be approved twice
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(approvemany), mvo()
+                                          ("level",    permission_level{ N(carol), config::active_name })
+                                          ("requests", fc::variants({
+                                             mvo()("proposer", "alice")("proposal_name", "second")("proposal_hash", fc::variant()),
+                                             mvo()("proposer", "alice")("proposal_name", "second")("proposal_hash", fc::variant()) }))
+                            ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("approval is not on the list of requested approvals")
+   );
+
+   push_action( N(alice), N(exec), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("executer",      "alice")
+   );
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( switch_proposal_and_fail_approve_with_hash, eosio_msig_tester ) try {
    auto trx1 = reqauth( N(alice), {permission_level{N(alice), config::active_name}}, abi_serializer_max_time );
    auto trx1_hash = fc::sha256::hash( trx1 );
@@ -994,9 +1161,279 @@ BOOST_FIXTURE_TEST_CASE( switch_proposal_and_fail_approve_with_hash, eosio_msig_
                                           ("level",         permission_level{ N(alice), config::active_name })
                                           ("proposal_hash", trx1_hash)
                             ),
-                            eosio::chain::crypto_api_exception,
-                            fc_exception_message_is("hash mismatch")
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("hash mismatch")
+   );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( approvals_sorted, eosio_msig_tester ) try {
+   vector<permission_level> perm = { { N(carol), config::active_name }, { N(alice), config::active_name }, { N(bob), config::active_name } };
+   auto trx = reqauth( N(alice), perm, abi_serializer_max_time );
+
+   push_action( N(alice), N(propose), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("trx",           trx)
+                  ("requested",     perm)
    );
+
+   auto apps = get_approvals( N(alice), N(first) );
+   BOOST_REQUIRE_EQUAL( 2, apps["version"].as<uint32_t>() );
+   BOOST_REQUIRE( vector<account_name>({ N(alice), N(bob), N(carol) }) == approval_actors( apps["requested_approvals"] ) );
+
+   for ( auto actor : { N(carol), N(alice) } ) {
+      push_action( actor, N(approve), mvo()
+                     ("proposer",      "alice")
+                     ("proposal_name", "first")
+                     ("level",         permission_level{ actor, config::active_name })
+      );
+   }
+   apps = get_approvals( N(alice), N(first) );
+   BOOST_REQUIRE( vector<account_name>({ N(bob) }) == approval_actors( apps["requested_approvals"] ) );
+   BOOST_REQUIRE( vector<account_name>({ N(alice), N(carol) }) == approval_actors( apps["provided_approvals"] ) );
+
+   push_action( N(carol), N(unapprove), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("level",         permission_level{ N(carol), config::active_name })
+   );
+   apps = get_approvals( N(alice), N(first) );
+   BOOST_REQUIRE( vector<account_name>({ N(bob), N(carol) }) == approval_actors( apps["requested_approvals"] ) );
+   BOOST_REQUIRE( vector<account_name>({ N(alice) }) == approval_actors( apps["provided_approvals"] ) );
+
+   BOOST_REQUIRE_EXCEPTION( push_action( N(alice), N(approve), mvo()
+                                          ("proposer",      "alice")
+                                          ("proposal_name", "first")
+                                          ("level",         permission_level{ N(alice), config::active_name })
+                            ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("approval is not on the list of requested approvals")
+   );
+   BOOST_REQUIRE_EXCEPTION( push_action( N(bob), N(unapprove), mvo()
+                                          ("proposer",      "alice")
+                                          ("proposal_name", "first")
+                                          ("level",         permission_level{ N(bob), config::active_name })
+                            ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("no approval previously granted")
+   );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( approvals_version_1_migration, eosio_msig_tester ) try {
+   vector<permission_level> perm = { { N(alice), config::active_name }, { N(bob), config::active_name }, { N(carol), config::active_name } };
+   auto trx = reqauth( N(alice), perm, abi_serializer_max_time );
+
+   push_action( N(alice), N(propose), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("trx",           trx)
+                  ("requested",     perm)
+   );
+
+   //recreate a row written by version 1 of the contract, with the approvals in the order they were added
+   auto level = []( account_name actor ) {
+      return mvo()("level", permission_level{ actor, config::active_name })("time", time_point());
+   };
+   set_approvals( N(alice), N(first), mvo()
+                  ("version",             1)
+                  ("proposal_name",       "first")
+                  ("requested_approvals", fc::variants({ level( N(carol) ), level( N(alice) ) }))
+                  ("provided_approvals",  fc::variants({ level( N(bob) ) }))
+   );
+
+   push_action( N(carol), N(approve), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("level",         permission_level{ N(carol), config::active_name })
+   );
+   auto apps = get_approvals( N(alice), N(first) );
+   BOOST_REQUIRE_EQUAL( 2, apps["version"].as<uint32_t>() );
+   BOOST_REQUIRE( vector<account_name>({ N(alice) }) == approval_actors( apps["requested_approvals"] ) );
+   BOOST_REQUIRE( vector<account_name>({ N(bob), N(carol) }) == approval_actors( apps["provided_approvals"] ) );
+
+   push_action( N(alice), N(approve), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("level",         permission_level{ N(alice), config::active_name })
+   );
+
+   transaction_trace_ptr trace;
+   control->applied_transaction.connect(
+   [&]( std::tuple<const transaction_trace_ptr&, const signed_transaction&> p ) {
+      const auto& t = std::get<0>(p);
+      if( t->scheduled ) { trace = t; }
+   } );
+
+   push_action( N(alice), N(exec), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("executer",      "alice")
+   );
+
+   BOOST_REQUIRE( bool(trace) );
+   BOOST_REQUIRE_EQUAL( 1, trace->action_traces.size() );
+   BOOST_REQUIRE_EQUAL( transaction_receipt::executed, trace->receipt->status );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( purge_expired_proposals, eosio_msig_tester ) try {
+   const auto alice_ram = control->get_resource_limits_manager().get_account_ram_usage( N(alice) );
+   for ( auto proposer : { N(alice), N(bob) } ) {
+      auto trx = reqauth( proposer, {permission_level{proposer, config::active_name}}, abi_serializer_max_time );
+      push_action( proposer, N(propose), mvo()
+                     ("proposer",      proposer)
+                     ("proposal_name", "first")
+                     ("trx",           trx)
+                     ("requested", vector<permission_level>{{ proposer, config::active_name }})
+      );
+   }
+   push_action( N(alice), N(approve), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("level",         permission_level{ N(alice), config::active_name })
+   );
+
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(purge), mvo()("max", 0) ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("max must be positive")
+   );
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(purge), mvo()("max", 10) ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("no expired proposals")
+   );
+
+   produce_block( fc::hours(1) );
+
+   //anyone can purge expired proposals, oldest first
+   push_action( N(carol), N(purge), mvo()("max", 1) );
+   BOOST_REQUIRE( get_proposal( N(alice), N(first) ).is_null() );
+   BOOST_REQUIRE( get_approvals( N(alice), N(first) ).is_null() );
+   BOOST_REQUIRE( !get_proposal( N(bob), N(first) ).is_null() );
+   BOOST_REQUIRE_EQUAL( alice_ram, control->get_resource_limits_manager().get_account_ram_usage( N(alice) ) );
+
+   push_action( N(carol), N(purge), mvo()("max", 10) );
+   BOOST_REQUIRE( get_proposal( N(bob), N(first) ).is_null() );
+   BOOST_REQUIRE( get_approvals( N(bob), N(first) ).is_null() );
+
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(purge), mvo()("max", 10) ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("no expired proposals")
+   );
+
+   //cancelled and executed proposals are not left behind in the expirations
+   auto trx = reqauth( N(alice), {permission_level{N(alice), config::active_name}}, abi_serializer_max_time );
+   trx.expiration = control->head_block_time() + fc::minutes(30);
+   for ( auto proposal_name : { N(second), N(third) } ) {
+      push_action( N(alice), N(propose), mvo()
+                     ("proposer",      "alice")
+                     ("proposal_name", proposal_name)
+                     ("trx",           trx)
+                     ("requested", vector<permission_level>{{ N(alice), config::active_name }})
+      );
+   }
+   push_action( N(alice), N(cancel), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "second")
+                  ("canceler",      "alice")
+   );
+   push_action( N(alice), N(approve), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "third")
+                  ("level",         permission_level{ N(alice), config::active_name })
+   );
+   push_action( N(alice), N(exec), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "third")
+                  ("executer",      "alice")
+   );
+   produce_block( fc::hours(1) );
+   BOOST_REQUIRE_EXCEPTION( push_action( N(carol), N(purge), mvo()("max", 10) ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("no expired proposals")
+   );
+   BOOST_REQUIRE_EQUAL( alice_ram, control->get_resource_limits_manager().get_account_ram_usage( N(alice) ) );
+} FC_LOG_AND_RETHROW()
+
+/**
+ * Executes a proposal approved by 100 accounts under both their owner and active permissions, after one of them
+ * invalidated and approved again, so that exec looks up the invalidations of adjacent approvals of the same actor.
+ */
+BOOST_FIXTURE_TEST_CASE( exec_many_approvals, eosio_msig_tester ) try {
+   const uint32_t num_approvers = 100;
+
+   vector<account_name> approvers;
+   vector<permission_level> perm;
+   for ( uint32_t i = 0; i < num_approvers; ++i ) {
+      std::string n = "approver";
+      for ( uint32_t d = 0, v = i; d < 4; ++d, v /= 26 ) {
+         n += char( 'a' + v % 26 );
+      }
+      approvers.emplace_back( n );
+      perm.push_back( { approvers.back(), config::owner_name } );
+      perm.push_back( { approvers.back(), config::active_name } );
+   }
+   create_accounts( approvers );
+   produce_block();
+
+   auto trx = reqauth( N(alice), perm, abi_serializer_max_time );
+   push_action( N(alice), N(propose), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("trx",           trx)
+                  ("requested",     perm)
+   );
+
+   auto approval = [&]( const action_name& act, const permission_level& level ) {
+      base_tester::push_action( N(eosio.msig), act, vector<permission_level>{ level }, mvo()
+                                ("proposer",      "alice")
+                                ("proposal_name", "first")
+                                ("level",         level)
+      );
+   };
+   for ( size_t i = 0; i < perm.size(); ++i ) {
+      approval( N(approve), perm[i] );
+      if ( i % 50 == 49 ) {
+         produce_block();
+      }
+   }
+   produce_block();
+
+   //both approvals of an approver in the middle of the list are invalidated
+   const account_name invalidated = approvers[num_approvers / 2];
+   push_action( invalidated, N(invalidate), mvo()
+                  ("account",      invalidated)
+   );
+   BOOST_REQUIRE_EXCEPTION( push_action( N(alice), N(exec), mvo()
+                                          ("proposer",      "alice")
+                                          ("proposal_name", "first")
+                                          ("executer",      "alice")
+                            ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("transaction authorization failed")
+   );
+
+   for ( const auto& p : { config::owner_name, config::active_name } ) {
+      approval( N(unapprove), { invalidated, p } );
+      approval( N(approve),   { invalidated, p } );
+   }
+   produce_block();
+
+   transaction_trace_ptr trace;
+   control->applied_transaction.connect(
+   [&]( std::tuple<const transaction_trace_ptr&, const signed_transaction&> p ) {
+      const auto& t = std::get<0>(p);
+      if( t->scheduled ) { trace = t; }
+   } );
+
+   push_action( N(alice), N(exec), mvo()
+                  ("proposer",      "alice")
+                  ("proposal_name", "first")
+                  ("executer",      "alice")
+   );
+
+   BOOST_REQUIRE( bool(trace) );
+   BOOST_REQUIRE_EQUAL( 1, trace->action_traces.size() );
+   BOOST_REQUIRE_EQUAL( transaction_receipt::executed, trace->receipt->status );
+   BOOST_REQUIRE( get_proposal( N(alice), N(first) ).is_null() );
 } FC_LOG_AND_RETHROW()
 
 BOOST_AUTO_TEST_SUITE_END()
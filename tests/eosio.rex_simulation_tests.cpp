@@ -0,0 +1,260 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/resource_limits.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <random>
+
+#include "eosio.system_tester.hpp"
+
+using namespace eosio_system;
+
+/**
+ * Randomized REX workload driven through the system contract. After every block the REX tables are
+ * checked against the accounting invariants below, and the time spent applying each action is
+ * reported per action name at the end of the run.
+ *
+ * The default size keeps the suite short. Larger runs can be configured through the environment:
+ *   REX_SIM_ACCOUNTS - number of REX accounts (default 50)
+ *   REX_SIM_BLOCKS   - number of blocks (default 240, 6 hours apart on average)
+ *   REX_SIM_ACTIONS  - number of actions pushed per block (default 20)
+ *   REX_SIM_SEED     - random seed (default 1)
+ */
+class rex_simulation_tester : public eosio_system_tester {
+public:
+
+   struct action_stats {
+      std::vector<int64_t> elapsed_us;
+      uint32_t             failed = 0;
+   };
+
+   static uint64_t env_or( const char* var, uint64_t def ) {
+      const char* v = std::getenv( var );
+      return v ? std::strtoull( v, nullptr, 10 ) : def;
+   }
+
+   static account_name sim_account( uint32_t i ) {
+      std::string n = "rexsim";
+      for ( int d = 0; d < 6; ++d ) {
+         n += char( 'a' + i % 26 );
+         i /= 26;
+      }
+      return account_name( n );
+   }
+
+   template<typename F>
+   void for_each_row( const name& table, const std::string& type, F&& f ) const {
+      const auto& db = control->db();
+      const auto* t_id = db.find<table_id_object, by_code_scope_table>( boost::make_tuple( config::system_account_name, config::system_account_name, table ) );
+      if ( !t_id ) {
+         return;
+      }
+
+      const auto& idx = db.get_index<key_value_index, by_scope_primary>();
+      for ( auto itr = idx.lower_bound( boost::make_tuple( t_id->id, 0 ) ); itr != idx.end() && itr->t_id == t_id->id; ++itr ) {
+         vector<char> data( itr->value.data(), itr->value.data() + itr->value.size() );
+         f( abi_ser.binary_to_variant( type, data, abi_serializer_max_time ) );
+      }
+   }
+
+   /**
+    * Every core token held by eosio.rex is accounted for by exactly one of: REX funds, the REX pool
+    * (lent or unlent), loan balances, proceeds of filled sell orders not yet moved to a fund, and
+    * return pool proceeds not yet distributed to the REX pool.
+    */
+   void check_rex_invariants() const {
+      const auto pool = get_rex_pool();
+      if ( pool.is_null() ) {
+         return;
+      }
+
+      const int64_t total_lendable = pool["total_lendable"].as<asset>().get_amount();
+      const int64_t total_lent     = pool["total_lent"].as<asset>().get_amount();
+      const int64_t total_unlent   = pool["total_unlent"].as<asset>().get_amount();
+      const int64_t total_rex      = pool["total_rex"].as<asset>().get_amount();
+      BOOST_REQUIRE_EQUAL( total_lendable, total_unlent + total_lent );
+      BOOST_REQUIRE_LE( 0, total_unlent );
+
+      int64_t rex_balances = 0;
+      for_each_row( N(rexbal), "rex_balance", [&]( const fc::variant& v ) {
+         const int64_t balance = v["rex_balance"].as<asset>().get_amount();
+         BOOST_REQUIRE_LE( 0, v["matured_rex"].as<int64_t>() );
+         BOOST_REQUIRE_LE( v["matured_rex"].as<int64_t>(), balance );
+         rex_balances += balance;
+      });
+      BOOST_REQUIRE_EQUAL( total_rex, rex_balances );
+
+      int64_t funds = 0;
+      for_each_row( N(rexfund), "rex_fund", [&]( const fc::variant& v ) {
+         BOOST_REQUIRE_LE( 0, v["balance"].as<asset>().get_amount() );
+         funds += v["balance"].as<asset>().get_amount();
+      });
+
+      int64_t lent = 0, loan_balances = 0;
+      for ( auto table : { N(cpuloan), N(netloan) } ) {
+         for_each_row( table, "rex_loan", [&]( const fc::variant& v ) {
+            lent          += v["total_staked"].as<asset>().get_amount();
+            loan_balances += v["balance"].as<asset>().get_amount();
+         });
+      }
+      BOOST_REQUIRE_EQUAL( total_lent, lent );
+
+      int64_t order_proceeds = 0;
+      for_each_row( N(rexqueue), "rex_order", [&]( const fc::variant& v ) {
+         if ( !v["is_open"].as<bool>() ) {
+            order_proceeds += v["proceeds"].as<asset>().get_amount();
+         }
+      });
+
+      int64_t undistributed = 0;
+      const auto return_pool = get_rex_return_pool();
+      if ( !return_pool.is_null() ) {
+         undistributed = return_pool["proceeds"].as<int64_t>();
+         BOOST_REQUIRE_LE( 0, undistributed );
+
+         int64_t bucket_rates = 0;
+         for ( const auto& b : get_rex_return_buckets()["return_buckets"].get_array() ) {
+            bucket_rates += b["value"].as<int64_t>();
+         }
+         BOOST_REQUIRE_EQUAL( return_pool["current_rate_of_increase"].as<int64_t>(), bucket_rates );
+      }
+
+      BOOST_REQUIRE_EQUAL( get_balance( N(eosio.rex) ).get_amount(),
+                           funds + total_lendable + loan_balances + order_proceeds + undistributed );
+   }
+
+   void setup_accounts( const std::vector<account_name>& accounts, const asset& init_balance ) {
+      const asset stake_quantity = core_sym::from_string("10.0000");
+      create_account_with_resources( N(proxyaccount), config::system_account_name, core_sym::from_string("1.0000"), false );
+      BOOST_REQUIRE_EQUAL( success(), push_action( N(proxyaccount), N(regproxy), mvo()("proxy", "proxyaccount")("isproxy", true) ) );
+      for ( size_t i = 0; i < accounts.size(); ++i ) {
+         const auto& a = accounts[i];
+         create_account_with_resources( a, config::system_account_name, core_sym::from_string("100.0000"), false );
+         transfer( config::system_account_name, a, init_balance + stake_quantity + stake_quantity, config::system_account_name );
+         BOOST_REQUIRE_EQUAL( success(), stake( a, a, stake_quantity, stake_quantity ) );
+         BOOST_REQUIRE_EQUAL( success(), vote( a, { }, N(proxyaccount) ) );
+         if ( i % 20 == 19 ) {
+            produce_block();
+         }
+      }
+      produce_block();
+   }
+
+   void sim_push( const name& act, const account_name& actor, const mvo& data ) {
+      auto& s = stats[act];
+      try {
+         auto trace = base_tester::push_action( config::system_account_name, act, actor, data );
+         s.elapsed_us.push_back( trace->elapsed.count() );
+      } catch ( const eosio_assert_message_exception& ) {
+         // rejected by the contract, e.g. insufficient funds or loans unavailable
+         ++s.failed;
+      } catch ( const ram_usage_exceeded& ) {
+         ++s.failed;
+      }
+   }
+
+   void random_action( const std::vector<account_name>& accounts, std::mt19937_64& rng ) {
+      auto pick   = [&]( uint64_t n ) { return std::uniform_int_distribution<uint64_t>( 0, n - 1 )( rng ); };
+      auto amount = [&]( int64_t max ) { return max > 0 ? int64_t( 1 + pick( uint64_t(max) ) ) : int64_t(1); };
+
+      const account_name a = accounts[pick( accounts.size() )];
+      const account_name b = accounts[pick( accounts.size() )];
+      const asset fund     = get_rex_fund( a );
+      const asset liquid   = get_balance( a );
+      const asset rex      = get_rex_balance( a );
+
+      switch ( pick( 10 ) ) {
+         case 0:
+            sim_push( N(deposit), a, mvo()("owner", a)("amount", asset( amount( liquid.get_amount() ), liquid.get_symbol() )) );
+            break;
+         case 1:
+            sim_push( N(withdraw), a, mvo()("owner", a)("amount", asset( amount( fund.get_amount() / 4 ), fund.get_symbol() )) );
+            break;
+         case 2:
+         case 3:
+            sim_push( N(buyrex), a, mvo()("from", a)("amount", asset( amount( fund.get_amount() / 2 ), fund.get_symbol() )) );
+            break;
+         case 4:
+         case 5:
+            sim_push( N(sellrex), a, mvo()("from", a)("rex", asset( amount( rex.get_amount() / 2 ), rex.get_symbol() )) );
+            break;
+         case 6:
+         case 7: {
+            const int64_t payment = amount( std::min<int64_t>( fund.get_amount() / 10, 100'0000 ) );
+            const int64_t reserve = int64_t( pick( 3 ) ) * payment;
+            sim_push( pick( 2 ) ? N(rentcpu) : N(rentnet), a, mvo()
+                      ("from",         a)
+                      ("receiver",     b)
+                      ("loan_payment", asset( payment, fund.get_symbol() ))
+                      ("loan_fund",    asset( reserve, fund.get_symbol() )) );
+            break;
+         }
+         case 8:
+            sim_push( N(buyram), a, mvo()("payer", a)("receiver", b)("quant", asset( amount( liquid.get_amount() / 10 ), liquid.get_symbol() )) );
+            break;
+         default:
+            sim_push( N(rexexec), a, mvo()("user", a)("max", 2) );
+            break;
+      }
+   }
+
+   void report_stats() const {
+      for ( const auto& [act, s] : stats ) {
+         auto elapsed = s.elapsed_us;
+         std::sort( elapsed.begin(), elapsed.end() );
+         auto percentile = [&]( double p ) -> int64_t {
+            return elapsed.empty() ? 0 : elapsed[ std::min<size_t>( elapsed.size() - 1, size_t( p * elapsed.size() ) ) ];
+         };
+         BOOST_TEST_MESSAGE( act.to_string() << ": " << elapsed.size() << " applied, " << s.failed << " rejected, elapsed us"
+                             << " p50 " << percentile( .5 ) << " p90 " << percentile( .9 ) << " p99 " << percentile( .99 )
+                             << " max " << ( elapsed.empty() ? 0 : elapsed.back() ) );
+      }
+   }
+
+   std::map<name, action_stats> stats;
+};
+
+BOOST_AUTO_TEST_SUITE(eosio_rex_simulation_tests)
+
+BOOST_FIXTURE_TEST_CASE( rex_randomized_workload, rex_simulation_tester ) try {
+   const uint64_t num_accounts = env_or( "REX_SIM_ACCOUNTS", 50 );
+   const uint64_t num_blocks   = env_or( "REX_SIM_BLOCKS",   240 );
+   const uint64_t num_actions  = env_or( "REX_SIM_ACTIONS",  20 );
+   const uint64_t seed         = env_or( "REX_SIM_SEED",     1 );
+   BOOST_TEST_MESSAGE( "rex simulation: " << num_accounts << " accounts, " << num_blocks << " blocks, "
+                       << num_actions << " actions per block, seed " << seed );
+
+   std::mt19937_64 rng( seed );
+
+   std::vector<account_name> accounts;
+   for ( uint32_t i = 0; i < num_accounts; ++i ) {
+      accounts.push_back( sim_account( i ) );
+   }
+   setup_accounts( accounts, core_sym::from_string("50000.0000") );
+
+   // seed the REX pool so that loans are available from the first block
+   BOOST_REQUIRE_EQUAL( success(), deposit( accounts[0], core_sym::from_string("40000.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( accounts[0], core_sym::from_string("40000.0000") ) );
+   check_rex_invariants();
+
+   for ( uint64_t blk = 0; blk < num_blocks; ++blk ) {
+      for ( uint64_t i = 0; i < num_actions; ++i ) {
+         random_action( accounts, rng );
+      }
+      produce_block( fc::seconds( std::uniform_int_distribution<int64_t>( 0, 12 * 3600 )( rng ) ) );
+      check_rex_invariants();
+   }
+
+   report_stats();
+
+   // the workload must have exercised the main REX entry points
+   for ( auto act : { N(buyrex), N(sellrex), N(rentcpu), N(rentnet), N(rexexec) } ) {
+      BOOST_REQUIRE( !stats[act].elapsed_us.empty() );
+   }
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,11 +3,15 @@
 #include <eosio/testing/tester.hpp>
 #include <eosio/chain/abi_serializer.hpp>
 #include <eosio/chain/resource_limits.hpp>
+#include <eosio/chain/snapshot.hpp>
 #include "contracts.hpp"
 #include "test_symbol.hpp"
 
 #include <fc/variant_object.hpp>
+#include <cstdlib>
 #include <fstream>
+#include <map>
+#include <sstream>
 
 using namespace eosio::chain;
 using namespace eosio::testing;
@@ -92,9 +96,44 @@ public:
       full
    };
 
+   /**
+    * The chain state of every setup level is built once per process and saved as a snapshot; later testers of the
+    * same level restore that snapshot instead of replaying the setup. Set EOSIO_SYSTEM_TESTER_SNAPSHOTS=0 to always
+    * replay the setup.
+    *
+    * Either way the setup transactions still pending are produced in a block, so every tester of a level starts
+    * from the same head block whether it replayed the setup or restored it.
+    */
    eosio_system_tester( setup_level l = setup_level::full ) {
       if( l == setup_level::none ) return;
 
+      if( !snapshots_enabled() ) {
+         setup( l );
+         produce_block();
+         return;
+      }
+
+      auto& snapshot = setup_snapshots()[l];
+      if( snapshot.empty() ) {
+         setup( l );
+         produce_block();
+         snapshot = take_snapshot();
+      } else {
+         restore_snapshot( snapshot, l );
+      }
+   }
+
+   template<typename Lambda>
+   eosio_system_tester(Lambda setup) {
+      setup(*this);
+
+      basic_setup();
+      create_core_token();
+      deploy_contract();
+      remaining_setup();
+   }
+
+   void setup( setup_level l ) {
       basic_setup();
       if( l == setup_level::minimal ) return;
 
@@ -107,14 +146,61 @@ public:
       remaining_setup();
    }
 
-   template<typename Lambda>
-   eosio_system_tester(Lambda setup) {
-      setup(*this);
+   static bool snapshots_enabled() {
+      const char* v = std::getenv( "EOSIO_SYSTEM_TESTER_SNAPSHOTS" );
+      return v == nullptr || std::string( v ) != "0";
+   }
 
-      basic_setup();
-      create_core_token();
-      deploy_contract();
-      remaining_setup();
+   static std::map<setup_level, std::string>& setup_snapshots() {
+      static std::map<setup_level, std::string> snapshots;
+      return snapshots;
+   }
+
+   // A snapshot can only be written without a pending block; the tester starts a new one with its next transaction.
+   std::string take_snapshot() {
+      control->abort_block();
+
+      std::ostringstream out;
+      auto writer = std::make_shared<ostream_snapshot_writer>( out );
+      control->write_snapshot( writer );
+      writer->finalize();
+      return out.str();
+   }
+
+   void restore_snapshot( const std::string& snapshot, setup_level l ) {
+      const auto dir = tempdir.path() / "snapshot";
+
+      close();
+      cfg.blocks_dir = dir / config::default_blocks_dir_name;
+      cfg.state_dir  = dir / config::default_state_dir_name;
+      {
+         std::istringstream in( snapshot );
+         open( std::make_shared<istream_snapshot_reader>( in ) );
+      }
+
+#ifndef NON_VALIDATING_TEST
+      validating_node.reset();
+      vcfg.blocks_dir = dir / std::string("v_").append( config::default_blocks_dir_name );
+      vcfg.state_dir  = dir / std::string("v_").append( config::default_state_dir_name );
+      {
+         std::istringstream in( snapshot );
+         validating_node = std::make_unique<controller>( vcfg, make_protocol_feature_set() );
+         validating_node->add_indices();
+         validating_node->startup( []() { return false; }, std::make_shared<istream_snapshot_reader>( in ) );
+      }
+#endif
+
+      load_abi( N(eosio.token), token_abi_ser );
+      if( l == setup_level::deploy_contract || l == setup_level::full ) {
+         load_abi( config::system_account_name, abi_ser );
+      }
+   }
+
+   void load_abi( account_name account, abi_serializer& ser ) {
+      const auto& accnt = control->db().get<account_object,by_name>( account );
+      abi_def abi;
+      BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abi), true);
+      ser.set_abi(abi, abi_serializer_max_time);
    }
 
 
@@ -260,6 +346,14 @@ public:
       return buyrambytes( account_name(payer), account_name(receiver), numbytes );
    }
 
+   action_result buyramfor( const account_name& payer, const vector<std::pair<account_name, asset>>& purchases ) {
+      fc::variants v;
+      for ( const auto& p : purchases ) {
+         v.push_back( mvo()("receiver", p.first)("quant", p.second) );
+      }
+      return push_action( payer, N(buyramfor), mvo()("payer", payer)("purchases", v) );
+   }
+
    action_result sellram( const account_name& account, uint64_t numbytes ) {
       return push_action( account, N(sellram), mvo()( "account", account)("bytes",numbytes) );
    }
@@ -337,6 +431,14 @@ public:
       return unstake( account_name(acnt), net, cpu );
    }
 
+   action_result delegatebws( const account_name& from, const vector<std::tuple<account_name, asset, asset>>& deltas ) {
+      fc::variants v;
+      for ( const auto& [receiver, net, cpu] : deltas ) {
+         v.push_back( mvo()("receiver", receiver)("net_delta", net)("cpu_delta", cpu) );
+      }
+      return push_action( from, N(delegatebws), mvo()("from", from)("deltas", v) );
+   }
+
    int64_t bancor_convert( int64_t S, int64_t R, int64_t T ) { return double(R) * T  / ( double(S) + T ); };
 
    int64_t get_net_limit( account_name a ) {
@@ -500,6 +602,35 @@ public:
       return _get_rentrex_result( from, receiver, payment, false );
    }
 
+   asset get_quote_result( const name& act, const string& arg, const asset& quantity ) {
+      auto trace = base_tester::push_action( config::system_account_name, act, N(alice1111111), mvo()( arg, quantity ) );
+
+      asset quote;
+      for ( size_t i = 0; i < trace->action_traces.size(); ++i ) {
+         if ( trace->action_traces[i].act.name == N(quoteresult) ) {
+            asset quoted;
+            fc::datastream<const char*> ds( trace->action_traces[i].act.data.data(), trace->action_traces[i].act.data.size() );
+            fc::raw::unpack( ds, quoted );
+            fc::raw::unpack( ds, quote );
+            BOOST_REQUIRE_EQUAL( quantity, quoted );
+            return quote;
+         }
+      }
+      return quote;
+   }
+
+   asset get_quoterex_result( const asset& quantity ) {
+      return get_quote_result( N(quoterex), "quantity", quantity );
+   }
+
+   asset get_quoteram_result( const asset& quantity ) {
+      return get_quote_result( N(quoteram), "quantity", quantity );
+   }
+
+   asset get_quoteloan_result( const asset& loan_payment ) {
+      return get_quote_result( N(quoteloan), "loan_payment", loan_payment );
+   }
+
    action_result fundcpuloan( const account_name& from, const uint64_t loan_num, const asset& payment ) {
       return push_action( name(from), N(fundcpuloan), mvo()
                           ("from",       from)
@@ -743,6 +874,30 @@ public:
       return bidname( account_name(bidder), account_name(newname), bid );
    }
 
+   action_result claimbidrefs( const account_name& bidder ) {
+      return push_action( name(bidder), N(claimbidrefs), mvo()("bidder", bidder) );
+   }
+   action_result claimbidrefs( std::string_view bidder ) {
+      return claimbidrefs( account_name(bidder) );
+   }
+
+   fc::variants get_bid_refunds( const account_name& bidder ) {
+      fc::variants refunds;
+      const auto& db = control->db();
+      const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>( boost::make_tuple( config::system_account_name, config::system_account_name, N(bidledger) ) );
+      if ( t_id ) {
+         const auto& idx = db.get_index<chain::key_value_index, chain::by_scope_primary>();
+         for ( auto itr = idx.lower_bound( boost::make_tuple( t_id->id, 0 ) ); itr != idx.end() && itr->t_id == t_id->id; ++itr ) {
+            vector<char> data( itr->value.data(), itr->value.data() + itr->value.size() );
+            auto r = abi_ser.binary_to_variant( "bid_refund_entry", data, abi_serializer_max_time );
+            if ( r["bidder"].as<account_name>() == bidder ) {
+               refunds.push_back( r );
+            }
+         }
+      }
+      return refunds;
+   }
+
    static fc::variant_object producer_parameters_example( int n ) {
       return mutable_variant_object()
          ("max_block_net_usage", 10000000 + n )
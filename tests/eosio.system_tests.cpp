@@ -3315,8 +3315,12 @@ BOOST_FIXTURE_TEST_CASE( multiple_namebids, eosio_system_tester ) try {
       const asset initial_names_balance = get_balance(N(eosio.names));
       BOOST_REQUIRE_EQUAL( success(),
                            bidname( "alice", "prefb", core_sym::from_string("1.1001") ) );
-      BOOST_REQUIRE_EQUAL( core_sym::from_string( "9997.9997" ), get_balance("bob") );
+      BOOST_REQUIRE_EQUAL( core_sym::from_string( "9996.9997" ), get_balance("bob") );
       BOOST_REQUIRE_EQUAL( core_sym::from_string( "9998.8999" ), get_balance("alice") );
+      BOOST_REQUIRE_EQUAL( initial_names_balance + core_sym::from_string("1.1001"), get_balance(N(eosio.names)) );
+      // bob is refunded once he claims
+      BOOST_REQUIRE_EQUAL( success(), claimbidrefs( "bob" ) );
+      BOOST_REQUIRE_EQUAL( core_sym::from_string( "9997.9997" ), get_balance("bob") );
       BOOST_REQUIRE_EQUAL( initial_names_balance + core_sym::from_string("0.1001"), get_balance(N(eosio.names)) );
    }
 
@@ -3326,6 +3330,8 @@ BOOST_FIXTURE_TEST_CASE( multiple_namebids, eosio_system_tester ) try {
       BOOST_REQUIRE_EQUAL( core_sym::from_string( "10000.0000" ), get_balance("david") );
       BOOST_REQUIRE_EQUAL( success(),
                            bidname( "david", "prefd", core_sym::from_string("1.9900") ) );
+      BOOST_REQUIRE_EQUAL( core_sym::from_string( "9998.0000" ), get_balance("carl") );
+      BOOST_REQUIRE_EQUAL( success(), claimbidrefs( "carl" ) );
       BOOST_REQUIRE_EQUAL( core_sym::from_string( "9999.0000" ), get_balance("carl") );
       BOOST_REQUIRE_EQUAL( core_sym::from_string( "9998.0100" ), get_balance("david") );
    }
@@ -3410,6 +3416,56 @@ BOOST_FIXTURE_TEST_CASE( multiple_namebids, eosio_system_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( bid_refund_ledger, eosio_system_tester ) try {
+
+   std::vector<account_name> accounts = { N(alice), N(bob), N(carl) };
+   create_accounts_with_resources( accounts );
+   for ( const auto& a: accounts ) {
+      transfer( config::system_account_name, a, core_sym::from_string( "10000.0000" ) );
+   }
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no bid refunds to claim" ), claimbidrefs( "bob" ) );
+
+   // bob is outbid twice on prefa and once on prefb
+   BOOST_REQUIRE_EQUAL( success(), bidname( "bob",   "prefa", core_sym::from_string("1.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), bidname( "alice", "prefa", core_sym::from_string("2.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), bidname( "bob",   "prefa", core_sym::from_string("3.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), bidname( "carl",  "prefa", core_sym::from_string("4.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), bidname( "bob",   "prefb", core_sym::from_string("5.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), bidname( "carl",  "prefb", core_sym::from_string("6.0000") ) );
+
+   // outbid amounts stay with eosio.names until claimed
+   BOOST_REQUIRE_EQUAL( core_sym::from_string( "9991.0000" ), get_balance("bob") );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string( "9998.0000" ), get_balance("alice") );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string( "21.0000" ), get_balance(N(eosio.names)) );
+
+   auto refunds = get_bid_refunds( N(bob) );
+   BOOST_REQUIRE_EQUAL( 2u, refunds.size() );
+   for ( const auto& r : refunds ) {
+      const auto expected = r["newname"].as<account_name>() == N(prefa) ? "4.0000" : "5.0000";
+      BOOST_REQUIRE_EQUAL( core_sym::from_string( expected ), r["amount"].as<asset>() );
+   }
+   BOOST_REQUIRE_EQUAL( 1u, get_bid_refunds( N(alice) ).size() );
+   BOOST_REQUIRE_EQUAL( 0u, get_bid_refunds( N(carl) ).size() );
+
+   BOOST_REQUIRE_EQUAL( error("missing authority of bob"),
+                        push_action( N(alice), N(claimbidrefs), mvo()("bidder", "bob") ) );
+
+   // one claim refunds all names
+   BOOST_REQUIRE_EQUAL( success(), claimbidrefs( "bob" ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string( "10000.0000" ), get_balance("bob") );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string( "12.0000" ), get_balance(N(eosio.names)) );
+   BOOST_REQUIRE_EQUAL( 0u, get_bid_refunds( N(bob) ).size() );
+   BOOST_REQUIRE_EQUAL( 1u, get_bid_refunds( N(alice) ).size() );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no bid refunds to claim" ), claimbidrefs( "bob" ) );
+
+   BOOST_REQUIRE_EQUAL( success(), claimbidrefs( "alice" ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string( "10000.0000" ), get_balance("alice") );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string( "10.0000" ), get_balance(N(eosio.names)) );
+
+} FC_LOG_AND_RETHROW()
+
+
 BOOST_FIXTURE_TEST_CASE( namebid_pending_winner, eosio_system_tester ) try {
    cross_15_percent_threshold();
    produce_block( fc::hours(14*24) );    //wait 14 day for name auction activation
@@ -3770,6 +3826,172 @@ BOOST_FIXTURE_TEST_CASE( ram_gift, eosio_system_tester ) try {
 } FC_LOG_AND_RETHROW()
 
 
+BOOST_FIXTURE_TEST_CASE( buyramfor, eosio_system_tester ) try {
+   const vector<std::pair<account_name, asset>> purchases = {
+      { N(bob111111111), core_sym::from_string("100.0000") },
+      { N(carol1111111), core_sym::from_string("2500.0001") },
+      { N(bob111111111), core_sym::from_string("0.0199") }
+   };
+
+   // reference chain where the same purchases are done one buyram at a time
+   eosio_system_tester seq;
+
+   transfer( "eosio", "alice1111111", core_sym::from_string("10000.0000"), "eosio" );
+   seq.transfer( "eosio", "alice1111111", core_sym::from_string("10000.0000"), "eosio" );
+   for ( const auto& p : purchases ) {
+      BOOST_REQUIRE_EQUAL( seq.success(), seq.buyram( N(alice1111111), p.first, p.second ) );
+   }
+
+   const asset initial_ram_balance    = get_balance( N(eosio.ram) );
+   const asset initial_ramfee_balance = get_balance( N(eosio.ramfee) );
+   BOOST_REQUIRE_EQUAL( success(), buyramfor( N(alice1111111), purchases ) );
+
+   // 0.5% fee is rounded up for each purchase: 0.5000 + 12.5001 + 0.0001
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("7399.9800"), get_balance( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( initial_ramfee_balance + core_sym::from_string("13.0002"), get_balance( N(eosio.ramfee) ) );
+   BOOST_REQUIRE_EQUAL( initial_ram_balance + core_sym::from_string("2587.0198"), get_balance( N(eosio.ram) ) );
+
+   for ( auto a : { N(alice1111111), N(eosio.ram), N(eosio.ramfee) } ) {
+      BOOST_REQUIRE_EQUAL( seq.get_balance( a ), get_balance( a ) );
+   }
+   for ( auto a : { N(bob111111111), N(carol1111111) } ) {
+      BOOST_REQUIRE_EQUAL( seq.get_total_stake( a )["ram_bytes"].as_int64(), get_total_stake( a )["ram_bytes"].as_int64() );
+      int64_t seq_ram = 0, ram = 0, net = 0, cpu = 0;
+      seq.control->get_resource_limits_manager().get_account_limits( a, seq_ram, net, cpu );
+      control->get_resource_limits_manager().get_account_limits( a, ram, net, cpu );
+      BOOST_REQUIRE_EQUAL( seq_ram, ram );
+   }
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no ram purchases provided"),
+                        buyramfor( N(alice1111111), {} ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must purchase a positive amount"),
+                        buyramfor( N(alice1111111), { { N(bob111111111), core_sym::from_string("1.0000") },
+                                                      { N(carol1111111), core_sym::from_string("0.0000") } } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must buy ram with core token"),
+                        buyramfor( N(alice1111111), { { N(bob111111111), asset::from_string("1.0000 TKN") } } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must reserve a positive amount"),
+                        buyramfor( N(alice1111111), { { N(bob111111111), core_sym::from_string("0.0001") } } ) );
+
+} FC_LOG_AND_RETHROW()
+
+
+BOOST_FIXTURE_TEST_CASE( process_refunds, eosio_system_tester ) try {
+   cross_15_percent_threshold();
+
+   const asset ten = core_sym::from_string("10.0000");
+   const std::vector<account_name> accounts = { N(alice1111111), N(bob111111111), N(carol1111111) };
+   for ( const auto& a : accounts ) {
+      transfer( "eosio", a, core_sym::from_string("1000.0000"), "eosio" );
+      BOOST_REQUIRE_EQUAL( success(), stake( a, a, core_sym::from_string("100.0000"), core_sym::from_string("100.0000") ) );
+   }
+
+   for ( const auto& a : accounts ) {
+      BOOST_REQUIRE_EQUAL( success(), unstake( a, a, ten, ten ) );
+      BOOST_REQUIRE( !get_refund_request( a ).is_null() );
+      BOOST_REQUIRE_EQUAL( core_sym::from_string("800.0000"), get_balance( a ) );
+   }
+   const auto procrefunds = [&]( const std::vector<account_name>& owners ) {
+      return push_action( N(alice1111111), N(procrefunds), mvo()("owners", owners) );
+   };
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no refunds available"), procrefunds( accounts ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no refunds available"), procrefunds( {} ) );
+
+   // refunds are not paid out automatically
+   produce_block( fc::hours(3*24) );
+   produce_blocks( 10 );
+   for ( const auto& a : accounts ) {
+      BOOST_REQUIRE_EQUAL( core_sym::from_string("800.0000"), get_balance( a ) );
+      BOOST_REQUIRE( !get_refund_request( a ).is_null() );
+   }
+
+   // an owner that rejects the transfer notification only fails the actions naming it
+   set_code( N(carol1111111), contracts::util::reject_all_wasm() );
+   BOOST_REQUIRE( success() != procrefunds( accounts ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("800.0000"), get_balance( N(alice1111111) ) );
+
+   // any account can process the refunds of other owners; owners without a matured refund are skipped
+   BOOST_REQUIRE_EQUAL( success(), procrefunds( { N(alice1111111), N(bob111111111), N(bob111111111), N(eosio.stake) } ) );
+   for ( auto a : { N(alice1111111), N(bob111111111) } ) {
+      BOOST_REQUIRE_EQUAL( core_sym::from_string("820.0000"), get_balance( a ) );
+      BOOST_REQUIRE( get_refund_request( a ).is_null() );
+   }
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no refunds available"), procrefunds( { N(alice1111111), N(bob111111111) } ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("800.0000"), get_balance( N(carol1111111) ) );
+   BOOST_REQUIRE( !get_refund_request( N(carol1111111) ).is_null() );
+
+} FC_LOG_AND_RETHROW()
+
+
+BOOST_FIXTURE_TEST_CASE( delegatebws, eosio_system_tester ) try {
+   const asset zero = core_sym::from_string("0.0000");
+   const vector<std::tuple<account_name, asset, asset>> deltas = {
+      { N(bob111111111), core_sym::from_string("50.0000"), core_sym::from_string("20.0000") },
+      { N(carol1111111), core_sym::from_string("10.0000"), zero },
+      { N(alice1111111), core_sym::from_string("-30.0000"), core_sym::from_string("-10.0000") },
+      { N(bob111111111), zero, core_sym::from_string("5.0000") }
+   };
+
+   transfer( "eosio", "alice1111111", core_sym::from_string("1000.0000"), "eosio" );
+   BOOST_REQUIRE_EQUAL( success(), stake( "alice1111111", "alice1111111", core_sym::from_string("100.0000"), core_sym::from_string("100.0000") ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("cannot undelegate bandwidth until the chain is activated (at least 15% of all tokens participate in voting)"),
+                        delegatebws( N(alice1111111), deltas ) );
+   cross_15_percent_threshold();
+
+   // reference chain where the same changes are done one delegatebw or undelegatebw at a time
+   eosio_system_tester seq;
+   seq.transfer( "eosio", "alice1111111", core_sym::from_string("1000.0000"), "eosio" );
+   BOOST_REQUIRE_EQUAL( seq.success(), seq.stake( "alice1111111", "alice1111111", core_sym::from_string("100.0000"), core_sym::from_string("100.0000") ) );
+   seq.cross_15_percent_threshold();
+   for ( const auto& [receiver, net, cpu] : deltas ) {
+      if ( net.get_amount() < 0 || cpu.get_amount() < 0 ) {
+         BOOST_REQUIRE_EQUAL( seq.success(), seq.unstake( N(alice1111111), receiver, -net, -cpu ) );
+      } else {
+         BOOST_REQUIRE_EQUAL( seq.success(), seq.stake( N(alice1111111), receiver, net, cpu ) );
+      }
+   }
+
+   const asset initial_stake_balance = get_balance( N(eosio.stake) );
+   BOOST_REQUIRE_EQUAL( success(), delegatebws( N(alice1111111), deltas ) );
+
+   // 5.0000 of the last change comes from the refund created by the unstake before it
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("720.0000"), get_balance( "alice1111111" ) );
+   BOOST_REQUIRE_EQUAL( initial_stake_balance + core_sym::from_string("80.0000"), get_balance( N(eosio.stake) ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("245.0000").get_amount(), get_voter_info( "alice1111111" )["staked"].as_int64() );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("30.0000"), get_refund_request( N(alice1111111) )["net_amount"].as<asset>() );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("5.0000"), get_refund_request( N(alice1111111) )["cpu_amount"].as<asset>() );
+
+   BOOST_REQUIRE_EQUAL( seq.get_balance( N(alice1111111) ), get_balance( N(alice1111111) ) );
+   BOOST_REQUIRE_EQUAL( seq.get_voter_info( "alice1111111" )["staked"].as_int64(), get_voter_info( "alice1111111" )["staked"].as_int64() );
+   REQUIRE_MATCHING_OBJECT( seq.get_refund_request( N(alice1111111) ), get_refund_request( N(alice1111111) ) );
+   for ( auto a : { N(alice1111111), N(bob111111111), N(carol1111111) } ) {
+      REQUIRE_MATCHING_OBJECT( seq.get_dbw_obj( N(alice1111111), a ), get_dbw_obj( N(alice1111111), a ) );
+      REQUIRE_MATCHING_OBJECT( seq.get_total_stake( a ), get_total_stake( a ) );
+      // limits of receivers changed more than once in the batch are written back once with the final values
+      int64_t seq_ram = 0, seq_net = 0, seq_cpu = 0, ram = 0, net = 0, cpu = 0;
+      seq.control->get_resource_limits_manager().get_account_limits( a, seq_ram, seq_net, seq_cpu );
+      control->get_resource_limits_manager().get_account_limits( a, ram, net, cpu );
+      BOOST_REQUIRE_EQUAL( seq_ram, ram );
+      BOOST_REQUIRE_EQUAL( seq_net, net );
+      BOOST_REQUIRE_EQUAL( seq_cpu, cpu );
+   }
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no bandwidth changes provided"),
+                        delegatebws( N(alice1111111), {} ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("should stake non-zero amount"),
+                        delegatebws( N(alice1111111), { { N(bob111111111), core_sym::from_string("1.0000"), zero },
+                                                        { N(carol1111111), zero, zero } } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("net and cpu deltas cannot be opposite signs"),
+                        delegatebws( N(alice1111111), { { N(bob111111111), core_sym::from_string("1.0000"), core_sym::from_string("-1.0000") } } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must use core token"),
+                        delegatebws( N(alice1111111), { { N(bob111111111), asset::from_string("1.0000 TKN"), asset::from_string("1.0000 TKN") } } ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("insufficient staked net bandwidth"),
+                        delegatebws( N(alice1111111), { { N(carol1111111), core_sym::from_string("-10.0001"), zero } } ) );
+   BOOST_REQUIRE_EQUAL( error("missing authority of alice1111111"),
+                        push_action( N(bob111111111), N(delegatebws), mvo()("from", "alice1111111")("deltas", fc::variants()) ) );
+
+} FC_LOG_AND_RETHROW()
+
+
 BOOST_FIXTURE_TEST_CASE( rex_auth, eosio_system_tester ) try {
 
    const std::vector<account_name> accounts = { N(aliceaccount), N(bobbyaccount) };
@@ -4117,6 +4339,98 @@ BOOST_FIXTURE_TEST_CASE( buy_rent_rex, eosio_system_tester ) try {
 } FC_LOG_AND_RETHROW()
 
 
+BOOST_FIXTURE_TEST_CASE( quote_rex_ram_loan, eosio_system_tester ) try {
+
+   const asset init_balance = core_sym::from_string("80000.0000");
+   const std::vector<account_name> accounts = { N(aliceaccount), N(bobbyaccount) };
+   account_name alice = accounts[0], bob = accounts[1];
+   setup_rex_accounts( accounts, init_balance );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("rex loans are currently not available"),
+                        push_action( alice, N(quoteloan), mvo()("loan_payment", core_sym::from_string("1.0000")) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("rex system not initialized yet"),
+                        push_action( alice, N(quoterex), mvo()("quantity", asset::from_string("1.0000 REX")) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("asset must be core token or REX"),
+                        push_action( alice, N(quoterex), mvo()("quantity", asset::from_string("1.0000 TKN")) ) );
+
+   // quotes are computed before the quoted action in the same block and have to match its outcome
+   {
+      const asset payment = core_sym::from_string("40000.0000");
+      const asset quote   = get_quoterex_result( payment );
+      BOOST_REQUIRE_EQUAL( quote, get_buyrex_result( alice, payment ) );
+   }
+   {
+      const asset payment = core_sym::from_string("123.4567");
+      const asset quote   = get_quoterex_result( payment );
+      BOOST_REQUIRE_EQUAL( quote, get_buyrex_result( bob, payment ) );
+   }
+   {
+      const asset rex   = asset::from_string("10000.0000 REX");
+      auto rex_pool     = get_rex_pool();
+      const int64_t S0  = rex_pool["total_lendable"].as<asset>().get_amount();
+      const int64_t R0  = rex_pool["total_rex"].as<asset>().get_amount();
+      BOOST_REQUIRE_EQUAL( asset( (__uint128_t(rex.get_amount()) * S0) / R0, symbol{CORE_SYM} ), get_quoterex_result( rex ) );
+   }
+   {
+      const asset payment = core_sym::from_string("20.0000");
+      const asset quote   = get_quoteloan_result( payment );
+      BOOST_REQUIRE_EQUAL( quote, get_rentcpu_result( bob, alice, payment ) );
+   }
+
+   // the rent paid above is distributed to the REX pool over time; quotes include the returns not yet added to it
+   produce_block( fc::days(1) );
+   {
+      const asset payment = core_sym::from_string("100.0000");
+      auto rex_pool       = get_rex_pool();
+      const int64_t S0    = rex_pool["total_lendable"].as<asset>().get_amount();
+      const int64_t R0    = rex_pool["total_rex"].as<asset>().get_amount();
+      const asset stored_pool_quote( (__uint128_t(S0 + payment.get_amount()) * R0) / S0 - R0, symbol{SY(4,REX)} );
+      const asset quote   = get_quoterex_result( payment );
+      BOOST_REQUIRE( quote < stored_pool_quote );
+      BOOST_REQUIRE_EQUAL( quote, get_buyrex_result( bob, payment ) );
+   }
+   produce_block( fc::days(1) );
+   {
+      const asset payment = core_sym::from_string("20.0000");
+      const asset quote   = get_quoteloan_result( payment );
+      BOOST_REQUIRE_EQUAL( quote, get_rentcpu_result( bob, alice, payment ) );
+   }
+
+   transfer( config::system_account_name, alice, core_sym::from_string("1000.0000"), config::system_account_name );
+   {
+      const asset   payment    = core_sym::from_string("300.0001");
+      const asset   quote      = get_quoteram_result( payment );
+      const int64_t init_bytes = get_total_stake( alice )["ram_bytes"].as_int64();
+      BOOST_REQUIRE_EQUAL( success(), buyram( alice, alice, payment ) );
+      BOOST_REQUIRE_EQUAL( asset::from_string( std::to_string( get_total_stake( alice )["ram_bytes"].as_int64() - init_bytes ) + " RAM" ),
+                           quote );
+   }
+   {
+      const asset bytes        = asset::from_string("4096 RAM");
+      const asset quote        = get_quoteram_result( bytes );
+      const asset init_balance = get_balance( alice );
+      BOOST_REQUIRE_EQUAL( success(), sellram( alice, bytes.get_amount() ) );
+      BOOST_REQUIRE_EQUAL( get_balance( alice ) - init_balance, quote );
+   }
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must quote ram with core token or RAM bytes"),
+                        push_action( alice, N(quoteram), mvo()("quantity", asset::from_string("1.0000 REX")) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("cannot sell negative byte"),
+                        push_action( alice, N(quoteram), mvo()("quantity", asset::from_string("0 RAM")) ) );
+
+   // trades that sellram and buyram reject are not quoted
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("token amount received from selling ram is too low"),
+                        sellram( alice, 1 ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("token amount received from selling ram is too low"),
+                        push_action( alice, N(quoteram), mvo()("quantity", asset::from_string("1 RAM")) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must reserve a positive amount"),
+                        buyram( alice, alice, core_sym::from_string("0.0001") ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must reserve a positive amount"),
+                        push_action( alice, N(quoteram), mvo()("quantity", core_sym::from_string("0.0001")) ) );
+
+} FC_LOG_AND_RETHROW()
+
+
 BOOST_FIXTURE_TEST_CASE( buy_sell_sell_rex, eosio_system_tester ) try {
 
    const int64_t ratio        = 10000;
@@ -4541,6 +4855,8 @@ BOOST_FIXTURE_TEST_CASE( ramfee_namebid_to_rex, eosio_system_tester ) try {
    BOOST_REQUIRE_EQUAL( success(),                        bidname( carol, N(rndmbid), core_sym::from_string("23.7000") ) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("23.7000"), get_balance( N(eosio.names) ) );
    BOOST_REQUIRE_EQUAL( success(),                        bidname( alice, N(rndmbid), core_sym::from_string("29.3500") ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("53.0500"), get_balance( N(eosio.names) ));
+   BOOST_REQUIRE_EQUAL( success(),                        claimbidrefs( carol ) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("29.3500"), get_balance( N(eosio.names) ));
 
    produce_block( fc::hours(24) );
@@ -5345,6 +5661,41 @@ BOOST_FIXTURE_TEST_CASE( b1_vesting, eosio_system_tester ) try {
 } FC_LOG_AND_RETHROW()
 
 
+BOOST_FIXTURE_TEST_CASE( rex_return_dist_guard, eosio_system_tester ) try {
+
+   constexpr uint32_t dist_interval = 10 * 60;
+   const asset init_balance = core_sym::from_string("100000.0000");
+   const std::vector<account_name> accounts = { N(aliceaccount), N(bobbyaccount) };
+   account_name alice = accounts[0], bob = accounts[1];
+   setup_rex_accounts( accounts, init_balance );
+
+   auto next_dist_time = [&]() { return get_global_state3()["next_rex_dist_time"].as<time_point_sec>().sec_since_epoch(); };
+   auto last_dist_time = [&]() { return get_rex_return_pool()["last_dist_time"].as<time_point_sec>().sec_since_epoch(); };
+
+   BOOST_REQUIRE_EQUAL( success(), buyrex( alice, core_sym::from_string("50000.0000") ) );
+   BOOST_REQUIRE_EQUAL( time_point_sec::maximum().sec_since_epoch(), next_dist_time() );
+
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( bob, bob, core_sym::from_string("30.0000") ) );
+   BOOST_REQUIRE_EQUAL( last_dist_time() + dist_interval, next_dist_time() );
+
+   // proceeds are distributed once the guard is reached, after which it moves to the next interval
+   produce_block( fc::hours(13) );
+   const int64_t init_lendable = get_rex_pool()["total_lendable"].as<asset>().get_amount();
+   BOOST_REQUIRE_EQUAL( success(), rexexec( bob, 1 ) );
+   const uint32_t dist_time = last_dist_time();
+   BOOST_REQUIRE_EQUAL( dist_time + dist_interval, next_dist_time() );
+   BOOST_REQUIRE( init_lendable < get_rex_pool()["total_lendable"].as<asset>().get_amount() );
+
+   // nothing is distributed before the guard
+   const asset lendable = get_rex_pool()["total_lendable"].as<asset>();
+   produce_blocks( 1 );
+   BOOST_REQUIRE( control->pending_block_time().sec_since_epoch() < next_dist_time() );
+   BOOST_REQUIRE_EQUAL( success(), rexexec( alice, 1 ) );
+   BOOST_REQUIRE_EQUAL( lendable,  get_rex_pool()["total_lendable"].as<asset>() );
+   BOOST_REQUIRE_EQUAL( dist_time, last_dist_time() );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( rex_return, eosio_system_tester ) try {
 
    constexpr uint32_t total_intervals = 30 * 144;
@@ -5528,8 +5879,16 @@ BOOST_AUTO_TEST_CASE( setabi_bios ) try {
       auto result = fc::sha256::hash( (const char*)abi.data(), abi.size() );
 
       BOOST_REQUIRE( abi_hash.hash == result );
+      BOOST_REQUIRE_EQUAL( abi.size(), abi_hash_var["size"].as<uint32_t>() );
+      BOOST_REQUIRE( block_timestamp_type( t.control->pending_block_time() ) == abi_hash_var["last_update"].as<block_timestamp_type>() );
+
+      // setting the same abi again does not rewrite the entry
+      t.produce_block();
+      t.set_abi( N(eosio.token), contracts::token_abi().data() );
+      BOOST_REQUIRE( res == t.get_row_by_account( config::system_account_name, config::system_account_name, N(abihash), N(eosio.token) ) );
    }
 
+   t.produce_block();
    t.set_abi( N(eosio.token), contracts::system_abi().data() );
    {
       auto res = t.get_row_by_account( config::system_account_name, config::system_account_name, N(abihash), N(eosio.token) );
@@ -5540,9 +5899,95 @@ BOOST_AUTO_TEST_CASE( setabi_bios ) try {
       auto result = fc::sha256::hash( (const char*)abi.data(), abi.size() );
 
       BOOST_REQUIRE( abi_hash.hash == result );
+      BOOST_REQUIRE_EQUAL( abi.size(), abi_hash_var["size"].as<uint32_t>() );
+      BOOST_REQUIRE( block_timestamp_type( t.control->pending_block_time() ) == abi_hash_var["last_update"].as<block_timestamp_type>() );
    }
 } FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE( setabi_lacchain ) try {
+   fc::temp_directory tempdir;
+   validating_tester t( tempdir, true );
+   t.execute_setup_policy( setup_policy::full );
+
+   // once lacchain.system is set, only entities can be created by the system account
+   t.create_account(N(eosio.token));
+   abi_serializer abi_ser(fc::json::from_string( (const char*)contracts::lacchain_abi().data()).template as<abi_def>(), base_tester::abi_serializer_max_time);
+   t.set_code( config::system_account_name, contracts::lacchain_wasm() );
+   t.set_abi( config::system_account_name, contracts::lacchain_abi().data() );
+
+   for ( const auto& abi_json : { contracts::token_abi(), contracts::system_abi() } ) {
+      t.produce_block();
+      t.set_abi( N(eosio.token), abi_json.data() );
+      const auto update_time = block_timestamp_type( t.control->pending_block_time() );
+
+      auto res = t.get_row_by_account( config::system_account_name, config::system_account_name, N(abihash), N(eosio.token) );
+      _abi_hash abi_hash;
+      auto abi_hash_var = abi_ser.binary_to_variant( "abi_hash", res, base_tester::abi_serializer_max_time );
+      abi_serializer::from_variant( abi_hash_var, abi_hash, t.get_resolver(), base_tester::abi_serializer_max_time);
+      auto abi = fc::raw::pack(fc::json::from_string( (const char*)abi_json.data()).template as<abi_def>());
+      auto result = fc::sha256::hash( (const char*)abi.data(), abi.size() );
+
+      BOOST_REQUIRE( abi_hash.hash == result );
+      BOOST_REQUIRE_EQUAL( abi.size(), abi_hash_var["size"].as<uint32_t>() );
+      BOOST_REQUIRE( update_time == abi_hash_var["last_update"].as<block_timestamp_type>() );
+
+      // setting the same abi again does not rewrite the entry
+      t.produce_block();
+      t.set_abi( N(eosio.token), abi_json.data() );
+      BOOST_REQUIRE( res == t.get_row_by_account( config::system_account_name, config::system_account_name, N(abihash), N(eosio.token) ) );
+      BOOST_REQUIRE( update_time != block_timestamp_type( t.control->pending_block_time() ) );
+   }
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( bootstrap_bios ) try {
+   fc::temp_directory tempdir;
+   validating_tester t( tempdir, true );
+   t.execute_setup_policy( setup_policy::full );
+
+   abi_serializer abi_ser(fc::json::from_string( (const char*)contracts::bios_abi().data()).template as<abi_def>(), base_tester::abi_serializer_max_time);
+   t.set_code( config::system_account_name, contracts::bios_wasm() );
+   t.set_abi( config::system_account_name, contracts::bios_abi().data() );
+   t.create_accounts( { N(eosio.token), N(eosio.msig), N(alice1111111) } );
+   t.produce_block();
+
+   auto abi = fc::raw::pack(fc::json::from_string( (const char*)contracts::token_abi().data()).template as<abi_def>());
+   auto token_abi_hash = fc::sha256::hash( (const char*)abi.data(), abi.size() );
+   auto bootstrap = mvo()
+      ("limits", fc::variants({ mvo()("account", "eosio.token")("ram_bytes", 1000000)("net_weight", 10)("cpu_weight", 20),
+                                mvo()("account", "eosio.msig")("ram_bytes", 2000000)("net_weight", 30)("cpu_weight", 40) }))
+      ("privileges", fc::variants({ mvo()("account", "eosio.msig")("is_priv", true) }))
+      ("abi_hashes", fc::variants({ mvo()("account", "eosio.token")("hash", token_abi_hash)("size", abi.size()) }));
+
+   BOOST_REQUIRE_EXCEPTION( t.push_action( config::system_account_name, N(bootstrap), N(alice1111111), bootstrap ),
+                            missing_auth_exception, fc_exception_message_starts_with("missing authority") );
+   t.push_action( config::system_account_name, N(bootstrap), config::system_account_name, bootstrap );
+
+   int64_t ram_bytes = 0, net_weight = 0, cpu_weight = 0;
+   t.control->get_resource_limits_manager().get_account_limits( N(eosio.token), ram_bytes, net_weight, cpu_weight );
+   BOOST_REQUIRE_EQUAL( 1000000, ram_bytes );
+   BOOST_REQUIRE_EQUAL( 10, net_weight );
+   BOOST_REQUIRE_EQUAL( 20, cpu_weight );
+   t.control->get_resource_limits_manager().get_account_limits( N(eosio.msig), ram_bytes, net_weight, cpu_weight );
+   BOOST_REQUIRE_EQUAL( 2000000, ram_bytes );
+   BOOST_REQUIRE_EQUAL( 30, net_weight );
+   BOOST_REQUIRE_EQUAL( 40, cpu_weight );
+
+   BOOST_REQUIRE( t.control->db().get<account_metadata_object, by_name>( N(eosio.msig) ).is_privileged() );
+   BOOST_REQUIRE( !t.control->db().get<account_metadata_object, by_name>( N(eosio.token) ).is_privileged() );
+
+   auto res = t.get_row_by_account( config::system_account_name, config::system_account_name, N(abihash), N(eosio.token) );
+   _abi_hash abi_hash;
+   auto abi_hash_var = abi_ser.binary_to_variant( "abi_hash", res, base_tester::abi_serializer_max_time );
+   abi_serializer::from_variant( abi_hash_var, abi_hash, t.get_resolver(), base_tester::abi_serializer_max_time);
+   BOOST_REQUIRE( abi_hash.hash == token_abi_hash );
+   BOOST_REQUIRE_EQUAL( abi.size(), abi_hash_var["size"].as<uint32_t>() );
+
+   // the recorded hash is the one setabi computes for the same abi, so setting it does not rewrite the entry
+   t.produce_block();
+   t.set_abi( N(eosio.token), contracts::token_abi().data() );
+   BOOST_REQUIRE( res == t.get_row_by_account( config::system_account_name, config::system_account_name, N(abihash), N(eosio.token) ) );
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( setabi, eosio_system_tester ) try {
    set_abi( N(eosio.token), contracts::token_abi().data() );
    {
@@ -2,11 +2,16 @@
 #include <eosio/testing/tester.hpp>
 #include <eosio/chain/abi_serializer.hpp>
 #include "eosio.system_tester.hpp"
+#include "token_ledger_exporter.hpp"
 
 #include "Runtime/Runtime.h"
 
 #include <fc/variant_object.hpp>
 
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+
 using namespace eosio::testing;
 using namespace eosio;
 using namespace eosio::chain;
@@ -63,6 +68,30 @@ public:
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account", data, abi_serializer_max_time );
    }
 
+   fc::variant get_compact_balance( account_name acc, const string& symbolname )
+   {
+      auto symb = eosio::chain::symbol::from_string(symbolname);
+      auto symbol_code = symb.to_symbol_code().value;
+      vector<char> data = get_row_by_account( N(eosio.token), acc, N(balances), account_name(symbol_code) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "compact_balance", data, abi_serializer_max_time );
+   }
+
+   fc::variant get_query_result( const action_name& query, const action_name& result, const variant_object& data ) {
+      auto trace = base_tester::push_action( N(eosio.token), query, N(alice), data );
+      for ( const auto& at : trace->action_traces ) {
+         if ( at.act.name == result ) {
+            return abi_ser.binary_to_variant( abi_ser.get_action_type( result ), at.act.data, abi_serializer_max_time );
+         }
+      }
+      return fc::variant();
+   }
+
+   action_result setcompact( const string& symbolcode ) {
+      return push_action( N(eosio.token), N(setcompact), mvo()
+           ( "sym", symbolcode )
+      );
+   }
+
    action_result create( account_name issuer,
                          asset        maximum_supply ) {
 
@@ -80,6 +109,17 @@ public:
       );
    }
 
+   action_result issuemany( account_name issuer,
+                            const vector<std::tuple<account_name, asset, string>>& entries ) {
+      fc::variants v;
+      for ( const auto& [to, quantity, memo] : entries ) {
+         v.push_back( mvo()("to", to)("quantity", quantity)("memo", memo) );
+      }
+      return push_action( issuer, N(issuemany), mvo()
+           ( "issues", v)
+      );
+   }
+
    action_result retire( account_name issuer, asset quantity, string memo ) {
       return push_action( issuer, N(retire), mvo()
            ( "quantity", quantity)
@@ -100,6 +140,18 @@ public:
       );
    }
 
+   action_result transfers( account_name from,
+                            const vector<std::tuple<account_name, asset, string>>& entries ) {
+      fc::variants v;
+      for ( const auto& [to, quantity, memo] : entries ) {
+         v.push_back( mvo()("to", to)("quantity", quantity)("memo", memo) );
+      }
+      return push_action( from, N(transfers), mvo()
+           ( "from", from)
+           ( "transfers", v)
+      );
+   }
+
    action_result open( account_name owner,
                        const string& symbolname,
                        account_name ram_payer    ) {
@@ -243,6 +295,59 @@ BOOST_FIXTURE_TEST_CASE( issue_tests, eosio_token_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( issuemany_tests, eosio_token_tester ) try {
+
+   create( N(alice), asset::from_string("1000.000 TKN") );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      issuemany( N(alice), { { N(bob),   asset::from_string("300.000 TKN"), "hola" },
+                             { N(carol), asset::from_string("200.000 TKN"), "" },
+                             { N(bob),   asset::from_string("50.000 TKN"),  "again" } } )
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_stats("3,TKN"), mvo()
+      ("supply", "550.000 TKN")
+      ("max_supply", "1000.000 TKN")
+      ("issuer", "alice")
+   );
+   BOOST_REQUIRE( get_account(N(alice), "3,TKN").is_null() );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob),   "3,TKN"), mvo()("balance", "350.000 TKN") );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "3,TKN"), mvo()("balance", "200.000 TKN") );
+
+   // the sum of all quantities is checked against the available supply
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "quantity exceeds available supply" ),
+      issuemany( N(alice), { { N(bob),   asset::from_string("400.000 TKN"), "" },
+                             { N(carol), asset::from_string("50.001 TKN"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( success(),
+      issuemany( N(alice), { { N(bob),   asset::from_string("400.000 TKN"), "" },
+                             { N(alice), asset::from_string("50.000 TKN"), "" } } )
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "3,TKN"), mvo()("balance", "50.000 TKN") );
+   BOOST_REQUIRE_EQUAL( asset::from_string("1000.000 TKN"), get_stats("3,TKN")["supply"].as<asset>() );
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ),
+      issuemany( N(bob), { { N(bob), asset::from_string("1.000 TKN"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no issues provided" ),
+      issuemany( N(alice), {} )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with symbol does not exist, create token before issue" ),
+      issuemany( N(alice), { { N(bob), asset::from_string("1.000 NKT"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "to account does not exist" ),
+      issuemany( N(alice), { { N(dave), asset::from_string("1.000 TKN"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "must issue positive quantity" ),
+      issuemany( N(alice), { { N(bob), asset::from_string("-1.000 TKN"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "symbol precision mismatch" ),
+      issuemany( N(alice), { { N(bob), asset::from_string("1.000 TKN"), "" },
+                             { N(carol), asset::from_string("1.00 TKN"), "" } } )
+   );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( retire_tests, eosio_token_tester ) try {
 
    auto token = create( N(alice), asset::from_string("1000.000 TKN"));
@@ -346,6 +451,205 @@ BOOST_FIXTURE_TEST_CASE( transfer_tests, eosio_token_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( transfers_tests, eosio_token_tester ) try {
+
+   create( N(alice), asset::from_string("1000 CERO") );
+   issue( N(alice), asset::from_string("1000 CERO"), "hola" );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      transfers( N(alice), { { N(bob),   asset::from_string("300 CERO"), "hola" },
+                             { N(carol), asset::from_string("200 CERO"), "" },
+                             { N(bob),   asset::from_string("50 CERO"),  "again" } } )
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,CERO"), mvo()("balance", "450 CERO") );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob),   "0,CERO"), mvo()("balance", "350 CERO") );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,CERO"), mvo()("balance", "200 CERO") );
+
+   // the whole batch fails if the sum overdraws the balance
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "overdrawn balance" ),
+      transfers( N(alice), { { N(bob), asset::from_string("400 CERO"), "" },
+                             { N(carol), asset::from_string("51 CERO"), "" } } )
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,CERO"), mvo()("balance", "350 CERO") );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no transfers provided" ),
+      transfers( N(alice), {} )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "cannot transfer to self" ),
+      transfers( N(alice), { { N(bob), asset::from_string("1 CERO"), "" },
+                             { N(alice), asset::from_string("1 CERO"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "to account does not exist" ),
+      transfers( N(alice), { { N(dave), asset::from_string("1 CERO"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "must transfer positive quantity" ),
+      transfers( N(alice), { { N(bob), asset::from_string("1 CERO"), "" },
+                             { N(carol), asset::from_string("-1 CERO"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "symbol precision mismatch" ),
+      transfers( N(alice), { { N(bob), asset::from_string("1 CERO"), "" },
+                             { N(carol), asset::from_string("1.0 CERO"), "" } } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "memo has more than 256 bytes" ),
+      transfers( N(alice), { { N(bob), asset::from_string("1 CERO"), string( 257, 'x' ) } } )
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( compact_balance_tests, eosio_token_tester ) try {
+
+   create( N(alice), asset::from_string("1000.000 TKN") );
+   issue( N(alice), asset::from_string("1000.000 TKN"), "hola" );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(bob), asset::from_string("300.000 TKN"), "hola" ) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "symbol does not exist" ), setcompact( "NKT" ) );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of eosio.token" ),
+                        push_action( N(alice), N(setcompact), mvo()("sym", "TKN") ) );
+   BOOST_REQUIRE_EQUAL( success(), setcompact( "TKN" ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "balances are already compact" ), setcompact( "TKN" ) );
+   BOOST_REQUIRE_EQUAL( asset::from_string("1000.000 TKN"), get_stats("3,TKN")["supply"].as<asset>() );
+
+   // the debited balance moves to the compact format, the credited one is updated in place
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(bob), asset::from_string("100.000 TKN"), "hola" ) );
+   BOOST_REQUIRE( get_account(N(alice), "3,TKN").is_null() );
+   REQUIRE_MATCHING_OBJECT( get_compact_balance(N(alice), "3,TKN"), mvo()("amount", 600000)("precision", 3) );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "3,TKN"), mvo()("balance", "400.000 TKN") );
+   BOOST_REQUIRE( get_compact_balance(N(bob), "3,TKN").is_null() );
+
+   // new balances are compact
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(carol), asset::from_string("50.000 TKN"), "hola" ) );
+   BOOST_REQUIRE( get_account(N(carol), "3,TKN").is_null() );
+   REQUIRE_MATCHING_OBJECT( get_compact_balance(N(carol), "3,TKN"), mvo()("amount", 50000)("precision", 3) );
+
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(alice), asset::from_string("400.000 TKN"), "hola" ) );
+   BOOST_REQUIRE( get_account(N(bob), "3,TKN").is_null() );
+   REQUIRE_MATCHING_OBJECT( get_compact_balance(N(bob),   "3,TKN"), mvo()("amount", 0)("precision", 3) );
+   REQUIRE_MATCHING_OBJECT( get_compact_balance(N(alice), "3,TKN"), mvo()("amount", 950000)("precision", 3) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "overdrawn balance" ),
+                        transfer( N(carol), N(alice), asset::from_string("50.001 TKN"), "hola" ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "Cannot close because the balance is not zero." ),
+                        push_action( N(carol), N(close), mvo()("owner", "carol")("symbol", "3,TKN") ) );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(bob), N(close), mvo()("owner", "bob")("symbol", "3,TKN") ) );
+   BOOST_REQUIRE( get_compact_balance(N(bob), "3,TKN").is_null() );
+
+   BOOST_REQUIRE_EQUAL( success(), open( N(bob), "3,TKN", N(alice) ) );
+   REQUIRE_MATCHING_OBJECT( get_compact_balance(N(bob), "3,TKN"), mvo()("amount", 0)("precision", 3) );
+
+   BOOST_REQUIRE_EQUAL( success(), retire( N(alice), asset::from_string("950.000 TKN"), "hola" ) );
+   REQUIRE_MATCHING_OBJECT( get_compact_balance(N(alice), "3,TKN"), mvo()("amount", 0)("precision", 3) );
+   BOOST_REQUIRE_EQUAL( asset::from_string("50.000 TKN"), get_stats("3,TKN")["supply"].as<asset>() );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( query_tests, eosio_token_tester ) try {
+
+   create( N(alice), asset::from_string("1000.000 TKN") );
+   issue( N(alice), asset::from_string("500.000 TKN"), "hola" );
+   transfer( N(alice), N(bob), asset::from_string("200.000 TKN"), "hola" );
+
+   REQUIRE_MATCHING_OBJECT( get_query_result( N(getsupply), N(supplyres), mvo()("sym", "TKN") ), mvo()
+      ("supply", "500.000 TKN")
+      ("max_supply", "1000.000 TKN")
+      ("issuer", "alice")
+   );
+   REQUIRE_MATCHING_OBJECT( get_query_result( N(getbalance), N(balanceres), mvo()("owner", "bob")("sym", "TKN") ), mvo()
+      ("owner", "bob")
+      ("balance", "200.000 TKN")
+   );
+
+   // compact balances are reported the same way
+   BOOST_REQUIRE_EQUAL( success(), setcompact( "TKN" ) );
+   transfer( N(alice), N(carol), asset::from_string("50.000 TKN"), "hola" );
+   REQUIRE_MATCHING_OBJECT( get_query_result( N(getbalance), N(balanceres), mvo()("owner", "carol")("sym", "TKN") ), mvo()
+      ("owner", "carol")
+      ("balance", "50.000 TKN")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "symbol does not exist" ),
+                        push_action( N(alice), N(getsupply), mvo()("sym", "NKT") ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no balance object found" ),
+                        push_action( N(alice), N(getbalance), mvo()("owner", "alice")("sym", "NKT") ) );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( ledger_export_tests, eosio_token_tester ) try {
+
+   BOOST_REQUIRE_EQUAL( success(), create( N(alice), asset::from_string("1000.000 TKN") ) );
+   BOOST_REQUIRE_EQUAL( success(), create( N(bob),   asset::from_string("500 CERO") ) );
+   BOOST_REQUIRE_EQUAL( success(), issue( N(alice), asset::from_string("1000.000 TKN"), "hola" ) );
+   BOOST_REQUIRE_EQUAL( success(), issue( N(bob),   asset::from_string("100 CERO"), "hola" ) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(bob), asset::from_string("300.000 TKN"), "hola" ) );
+   BOOST_REQUIRE_EQUAL( success(), setcompact( "CERO" ) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(carol), asset::from_string("40 CERO"), "hola" ) );
+
+   eosio_token_export::token_ledger_exporter exporter( control->db(), N(eosio.token), abi_ser );
+   std::ostringstream balances, stats;
+   const auto counts = exporter.run( balances, stats );
+   BOOST_REQUIRE_EQUAL( 4u, counts.balances );
+   BOOST_REQUIRE_EQUAL( 2u, counts.stats );
+
+   // rows are exported in (scope, table, primary key) order; stat tables are scoped by the raw symbol code
+   BOOST_REQUIRE_EQUAL( "owner,symbol,precision,amount\n"
+                        "alice,TKN,3,700000\n"
+                        "bob,TKN,3,300000\n"
+                        "bob,CERO,0,60\n"
+                        "carol,CERO,0,40\n", balances.str() );
+   BOOST_REQUIRE_EQUAL( "symbol,precision,supply,max_supply,issuer\n"
+                        "TKN,3,1000000,1000000,alice\n"
+                        "CERO,0,100,500,bob\n", stats.str() );
+
+} FC_LOG_AND_RETHROW()
+
+/**
+ * Exports a synthetic ledger of TOKEN_EXPORT_HOLDERS balances written directly to chain state and reports the
+ * throughput, e.g. TOKEN_EXPORT_HOLDERS=1000000 for a million-holder state. Skipped when it is not set.
+ */
+BOOST_FIXTURE_TEST_CASE( ledger_export_benchmark, eosio_token_tester ) try {
+
+   const char* env = std::getenv( "TOKEN_EXPORT_HOLDERS" );
+   if ( !env ) {
+      BOOST_TEST_MESSAGE( "ledger_export_benchmark skipped, TOKEN_EXPORT_HOLDERS is not set" );
+      return;
+   }
+   const uint64_t holders = std::strtoull( env, nullptr, 10 );
+
+   BOOST_REQUIRE_EQUAL( success(), create( N(alice), asset::from_string("1000000000.0000 TKN") ) );
+   const auto sym = eosio::chain::symbol::from_string("4,TKN");
+
+   auto& db = control->mutable_db();
+   for ( uint64_t i = 0; i < holders; ++i ) {
+      const account_name owner( ( i + 1 ) << 4 );
+      const auto& t = db.create<table_id_object>( [&]( auto& t ) {
+         t.code  = N(eosio.token);
+         t.scope = owner;
+         t.table = N(accounts);
+         t.payer = owner;
+         t.count = 1;
+      });
+      const auto row = fc::raw::pack( asset( int64_t( i + 1 ), sym ) );
+      db.create<key_value_object>( [&]( auto& o ) {
+         o.t_id        = t.id;
+         o.primary_key = sym.to_symbol_code().value;
+         o.value.assign( row.data(), row.size() );
+         o.payer       = owner;
+      });
+   }
+
+   eosio_token_export::token_ledger_exporter exporter( control->db(), N(eosio.token), abi_ser );
+   std::ostringstream balances, stats;
+   const auto start  = std::chrono::steady_clock::now();
+   const auto counts = exporter.run( balances, stats );
+   const auto us     = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+
+   BOOST_REQUIRE_EQUAL( holders, counts.balances );
+   BOOST_REQUIRE_EQUAL( 1u, counts.stats );
+   BOOST_TEST_MESSAGE( "exported " << counts.balances << " balances (" << balances.str().size() << " bytes) in "
+                       << us << " us, " << ( us ? counts.balances * 1000000 / us : 0 ) << " rows/s" );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( open_tests, eosio_token_tester ) try {
 
    auto token = create( N(alice), asset::from_string("1000 CERO"));
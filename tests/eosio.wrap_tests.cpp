@@ -111,6 +111,17 @@ public:
 
    transaction wrap_exec( account_name executer, const transaction& trx, uint32_t expiration = base_tester::DEFAULT_EXPIRATION_DELTA );
 
+   transaction wrap_execmany( account_name executer, const vector<transaction>& trxs, uint32_t expiration = base_tester::DEFAULT_EXPIRATION_DELTA );
+
+   void push_signed( const transaction& trx ) {
+      signed_transaction signed_trx( transaction( trx ), {}, {} );
+      signed_trx.sign( get_private_key( N(alice), "active" ), control->get_chain_id() );
+      for( const auto& actor : {N(prod1), N(prod2), N(prod3), N(prod4)} ) {
+         signed_trx.sign( get_private_key( actor, "active" ), control->get_chain_id() );
+      }
+      push_transaction( signed_trx );
+   }
+
    transaction reqauth( account_name from, const vector<permission_level>& auths, uint32_t expiration = base_tester::DEFAULT_EXPIRATION_DELTA );
 
    abi_serializer abi_ser;
@@ -139,6 +150,20 @@ transaction eosio_wrap_tester::wrap_exec( account_name executer, const transacti
    return trx2;
 }
 
+transaction eosio_wrap_tester::wrap_execmany( account_name executer, const vector<transaction>& trxs, uint32_t expiration ) {
+   auto act_obj = fc::mutable_variant_object()
+                     ("account", "eosio.wrap")
+                     ("name", "execmany")
+                     ("authorization", vector<permission_level>{ { executer, config::active_name }, { N(eosio.wrap), config::active_name } })
+                     ("data", fc::mutable_variant_object()("executer", executer)("trxs", trxs) );
+   transaction trx;
+   set_transaction_headers(trx, expiration);
+   action act;
+   abi_serializer::from_variant( act_obj, act, get_resolver(), abi_serializer_max_time );
+   trx.actions.push_back( std::move(act) );
+   return trx;
+}
+
 transaction eosio_wrap_tester::reqauth( account_name from, const vector<permission_level>& auths, uint32_t expiration ) {
    fc::variants v;
    for ( auto& level : auths ) {
@@ -365,4 +390,76 @@ BOOST_FIXTURE_TEST_CASE( wrap_with_msig_producers_change, eosio_wrap_tester ) tr
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( wrap_exec_same_block, eosio_wrap_tester ) try {
+   vector<transaction_trace_ptr> traces;
+   control->applied_transaction.connect(
+   [&]( std::tuple<const transaction_trace_ptr&, const signed_transaction&> p ) {
+      const auto& t = std::get<0>(p);
+      if( t->scheduled ) {
+         traces.push_back( t );
+      }
+   } );
+
+   // both wrapped transactions are scheduled although they are sent at the same time by the same executer
+   push_signed( wrap_exec( N(alice), reqauth( N(bob), {permission_level{N(bob), config::active_name}} ) ) );
+   push_signed( wrap_exec( N(alice), reqauth( N(carol), {permission_level{N(carol), config::active_name}} ) ) );
+
+   produce_block();
+
+   BOOST_REQUIRE_EQUAL( 2, traces.size() );
+   for ( const auto& t : traces ) {
+      BOOST_REQUIRE_EQUAL( N(reqauth), name{t->action_traces[0].act.name} );
+      BOOST_REQUIRE_EQUAL( transaction_receipt::executed, t->receipt->status );
+   }
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( wrap_execmany_direct, eosio_wrap_tester ) try {
+   auto trx1 = reqauth( N(bob), {permission_level{N(bob), config::active_name}} );
+   auto trx2 = reqauth( N(carol), {permission_level{N(carol), config::active_name}} );
+   auto trx3 = reqauth( N(alice), {permission_level{N(alice), config::active_name}} );
+   trx3.delay_sec = 3;
+
+   BOOST_REQUIRE_EXCEPTION( push_signed( wrap_execmany( N(alice), {} ) ),
+                            eosio_assert_message_exception,
+                            eosio_assert_message_is("no transactions provided")
+   );
+
+   vector<transaction_trace_ptr> traces;
+   control->applied_transaction.connect(
+   [&]( std::tuple<const transaction_trace_ptr&, const signed_transaction&> p ) {
+      const auto& t = std::get<0>(p);
+      if( t->scheduled ) {
+         traces.push_back( t );
+      }
+   } );
+
+   signed_transaction wrap_trx( wrap_execmany( N(alice), { trx1, trx2, trx3 } ), {}, {} );
+   wrap_trx.sign( get_private_key( N(alice), "active" ), control->get_chain_id() );
+   for( const auto& actor : {N(prod1), N(prod2), N(prod3), N(prod4)} ) {
+      wrap_trx.sign( get_private_key( actor, "active" ), control->get_chain_id() );
+   }
+   auto trace = push_transaction( wrap_trx );
+
+   // transactions without delay are executed as inline actions
+   BOOST_REQUIRE_EQUAL( 3, trace->action_traces.size() );
+   BOOST_REQUIRE_EQUAL( N(execmany), name{trace->action_traces[0].act.name} );
+   BOOST_REQUIRE_EQUAL( N(reqauth), name{trace->action_traces[1].act.name} );
+   BOOST_REQUIRE_EQUAL( N(bob), trace->action_traces[1].act.authorization[0].actor );
+   BOOST_REQUIRE_EQUAL( N(reqauth), name{trace->action_traces[2].act.name} );
+   BOOST_REQUIRE_EQUAL( N(carol), trace->action_traces[2].act.authorization[0].actor );
+
+   // the delayed transaction is deferred
+   produce_block();
+   BOOST_REQUIRE_EQUAL( 0, traces.size() );
+   produce_block( fc::seconds(3) );
+   produce_block();
+
+   BOOST_REQUIRE_EQUAL( 1, traces.size() );
+   BOOST_REQUIRE_EQUAL( N(reqauth), name{traces[0]->action_traces[0].act.name} );
+   BOOST_REQUIRE_EQUAL( N(alice), traces[0]->action_traces[0].act.authorization[0].actor );
+   BOOST_REQUIRE_EQUAL( transaction_receipt::executed, traces[0]->receipt->status );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
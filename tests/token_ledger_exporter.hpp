@@ -0,0 +1,98 @@
+#pragma once
+
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <cstring>
+#include <ostream>
+
+namespace eosio_token_export {
+
+using namespace eosio::chain;
+
+struct export_counts {
+   uint64_t balances = 0;
+   uint64_t stats    = 0;
+};
+
+/**
+ * Streams every balance and token stat row of the token contract `code` from chain state as CSV, in a single
+ * sequential pass over the contract's tables and without buffering rows:
+ *   balances_out - owner,symbol,precision,amount   (from both the `accounts` and the compact `balances` tables)
+ *   stats_out    - symbol,precision,supply,max_supply,issuer
+ * Amounts are written as integers in the smallest unit of the token.
+ *
+ * Rows are decoded from their fixed binary layout; `abi` is only used to check up front that the contract's
+ * row types have that layout. The token_ledger_export tool runs it on a state directory or snapshot.
+ */
+class token_ledger_exporter {
+public:
+   token_ledger_exporter( const chainbase::database& db, const account_name& code, const abi_serializer& abi )
+   :db(db), code(code) {
+      check_fields( abi, "account",         { "balance" } );
+      check_fields( abi, "currency_stats",  { "supply", "max_supply", "issuer" } );
+      check_fields( abi, "compact_balance", { "amount", "precision" } );
+   }
+
+   export_counts run( std::ostream& balances_out, std::ostream& stats_out ) const {
+      balances_out << "owner,symbol,precision,amount\n";
+      stats_out    << "symbol,precision,supply,max_supply,issuer\n";
+
+      export_counts counts;
+      const auto& tables = db.get_index<table_id_multi_index, by_code_scope_table>();
+      const auto& rows   = db.get_index<key_value_index, by_scope_primary>();
+      for ( auto t = tables.lower_bound( boost::make_tuple( code, name(), name() ) ); t != tables.end() && t->code == code; ++t ) {
+         if ( t->table != N(accounts) && t->table != N(balances) && t->table != N(stat) ) {
+            continue;
+         }
+         for ( auto r = rows.lower_bound( boost::make_tuple( t->id, 0 ) ); r != rows.end() && r->t_id == t->id; ++r ) {
+            const char* data = r->value.data();
+            const size_t size = r->value.size();
+            if ( t->table == N(accounts) ) {
+               EOS_ASSERT( size >= 16, fc::assert_exception, "invalid accounts row" );
+               write_balance( balances_out, t->scope, read<uint64_t>( data + 8 ), read<int64_t>( data ) );
+               ++counts.balances;
+            } else if ( t->table == N(balances) ) {
+               EOS_ASSERT( size >= 9, fc::assert_exception, "invalid balances row" );
+               write_balance( balances_out, t->scope, ( r->primary_key << 8 ) | uint8_t( data[8] ), read<int64_t>( data ) );
+               ++counts.balances;
+            } else {
+               EOS_ASSERT( size >= 40, fc::assert_exception, "invalid stat row" );
+               const symbol sym( read<uint64_t>( data + 8 ) );
+               stats_out << sym.name() << ',' << uint32_t( sym.decimals() ) << ','
+                         << read<int64_t>( data ) << ',' << read<int64_t>( data + 16 ) << ','
+                         << name( read<uint64_t>( data + 32 ) ).to_string() << '\n';
+               ++counts.stats;
+            }
+         }
+      }
+      return counts;
+   }
+
+private:
+   template<typename T>
+   static T read( const char* p ) {
+      T v;
+      std::memcpy( &v, p, sizeof(T) );
+      return v;
+   }
+
+   static void write_balance( std::ostream& out, const name& owner, uint64_t sym_value, int64_t amount ) {
+      const symbol sym( sym_value );
+      out << owner.to_string() << ',' << sym.name() << ',' << uint32_t( sym.decimals() ) << ',' << amount << '\n';
+   }
+
+   static void check_fields( const abi_serializer& abi, const std::string& type, const std::vector<std::string>& fields ) {
+      const auto& s = abi.get_struct( type );
+      EOS_ASSERT( s.fields.size() >= fields.size(), fc::assert_exception, "unexpected layout of ${t}", ("t", type) );
+      for ( size_t i = 0; i < fields.size(); ++i ) {
+         EOS_ASSERT( s.fields[i].name == fields[i], fc::assert_exception, "unexpected layout of ${t}", ("t", type) );
+      }
+   }
+
+   const chainbase::database& db;
+   const account_name         code;
+};
+
+} // namespace eosio_token_export
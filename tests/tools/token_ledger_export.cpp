@@ -0,0 +1,104 @@
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/account_object.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/chain/controller.hpp>
+#include <eosio/chain/snapshot.hpp>
+#include <eosio/testing/tester.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/filesystem.hpp>
+
+#include <chainbase/chainbase.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "token_ledger_exporter.hpp"
+
+using namespace eosio::chain;
+
+/**
+ * Exports the balances and token stats of a token contract from an existing chain state as CSV, see
+ * token_ledger_exporter.hpp for the format. The chain state is read from either:
+ *   --state-dir DIR  - the state directory of a stopped node, opened read-only
+ *   --snapshot FILE  - a binary snapshot, loaded into a temporary state directory
+ *
+ * usage: token_ledger_export (--state-dir DIR | --snapshot FILE) [--code ACCOUNT] BALANCES_CSV STATS_CSV
+ */
+namespace {
+
+const fc::microseconds abi_serializer_max_time = fc::seconds(10);
+
+int usage() {
+   std::cerr << "usage: token_ledger_export (--state-dir DIR | --snapshot FILE) [--code ACCOUNT] BALANCES_CSV STATS_CSV" << std::endl;
+   return 1;
+}
+
+int export_ledger( const chainbase::database& db, const account_name& code, const std::string& balances_path, const std::string& stats_path ) {
+   abi_def abi;
+   EOS_ASSERT( abi_serializer::to_abi( db.get<account_object, by_name>( code ).abi, abi ), fc::assert_exception,
+               "${code} has no abi", ("code", code) );
+   const abi_serializer abi_ser( abi, abi_serializer_max_time );
+
+   std::ofstream balances( balances_path ), stats( stats_path );
+   EOS_ASSERT( balances && stats, fc::assert_exception, "cannot open the output files" );
+   const auto counts = eosio_token_export::token_ledger_exporter( db, code, abi_ser ).run( balances, stats );
+   std::cout << "exported " << counts.balances << " balances and " << counts.stats << " token stats of " << code << std::endl;
+   return 0;
+}
+
+} // namespace
+
+int main( int argc, char** argv ) {
+   fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::off);
+
+   std::string state_dir, snapshot, balances_path, stats_path;
+   account_name code = N(eosio.token);
+   for ( int i = 1; i < argc; ++i ) {
+      const std::string arg = argv[i];
+      if ( arg == "--state-dir" && i + 1 < argc ) {
+         state_dir = argv[++i];
+      } else if ( arg == "--snapshot" && i + 1 < argc ) {
+         snapshot = argv[++i];
+      } else if ( arg == "--code" && i + 1 < argc ) {
+         code = account_name( argv[++i] );
+      } else if ( balances_path.empty() ) {
+         balances_path = arg;
+      } else if ( stats_path.empty() ) {
+         stats_path = arg;
+      } else {
+         return usage();
+      }
+   }
+   if ( state_dir.empty() == snapshot.empty() || stats_path.empty() ) {
+      return usage();
+   }
+
+   try {
+      if ( !state_dir.empty() ) {
+         // only the indices read by the exporter are opened
+         chainbase::database db( state_dir, chainbase::database::read_only );
+         db.add_index<account_index>();
+         db.add_index<table_id_multi_index>();
+         db.add_index<key_value_index>();
+         return export_ledger( db, code, balances_path, stats_path );
+      }
+
+      std::ifstream in( snapshot, std::ios::in | std::ios::binary );
+      EOS_ASSERT( in, fc::assert_exception, "cannot open snapshot ${s}", ("s", snapshot) );
+      fc::temp_directory tempdir;
+      controller::config cfg;
+      cfg.blocks_dir = tempdir.path() / config::default_blocks_dir_name;
+      cfg.state_dir  = tempdir.path() / config::default_state_dir_name;
+      controller control( cfg, eosio::testing::make_protocol_feature_set() );
+      control.add_indices();
+      control.startup( []() { return false; }, std::make_shared<istream_snapshot_reader>( in ) );
+      return export_ledger( control.db(), code, balances_path, stats_path );
+   } catch ( const fc::exception& e ) {
+      std::cerr << e.to_detail_string() << std::endl;
+   } catch ( const std::exception& e ) {
+      std::cerr << e.what() << std::endl;
+   }
+   return 1;
+}